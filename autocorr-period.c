@@ -0,0 +1,404 @@
+/*!
+ * Fixed-Point Autocorrelation Period Estimator
+ *
+ * r[k] = sum (x[i] - mean) * (x[i + k] - mean) over the n - k overlapping
+ * samples (biased). For a periodic signal r has local maxima at every
+ * multiple of the period, with the bias making the first one the
+ * highest, so the dominant period is the highest local maximum of r in
+ * [min_lag, max_lag].
+ *
+ * FFT path: the mean-removed signal is zero-padded to a power of two
+ * N >= n + max_lag (so the circular correlation equals the linear one
+ * up to max_lag), transformed, squared in magnitude and transformed
+ * back. Data are int32 with a shared exponent (block floating point):
+ * before each butterfly stage the block is halved if any component
+ * could overflow, so no per-sample scaling is lost to worst-case
+ * assumptions. Twiddles are Q2.30 from a short Taylor series on
+ * [0, pi/4] with octant symmetry. Only relative values of r matter, so
+ * the exponent is not tracked.
+ */
+
+#include <stddef.h>
+#include "autocorr-period.h"
+
+/* 2 * pi in Q2.30 */
+#define AC_TWO_PI_Q30 (6746518852LL)
+#define AC_Q30_ONE (1LL << 30)
+
+/* Largest component magnitude allowed before a butterfly stage */
+#define AC_BFP_LIMIT (1L << 29)
+
+/* Local-maximum picker over r[k] fed in increasing lag order */
+typedef struct {
+    int64_t prev2;           /* r[lag - 2] */
+    int64_t prev1;           /* r[lag - 1] */
+    int32_t min_lag;
+    int32_t best_lag;
+    int64_t best;
+} AcPick;
+
+/*!
+ * @brief Feed r[lag]; decides whether lag - 1 was a local maximum.
+ */
+static void ac_pick_push(AcPick *pick, int32_t lag, int64_t r)
+{
+    int32_t peak_lag = lag - 1;
+
+    if ((peak_lag >= pick->min_lag) && (pick->prev1 > pick->prev2) &&
+        (pick->prev1 >= r) && (pick->prev1 > 0) &&
+        ((pick->best_lag < 0) || (pick->prev1 > pick->best))) {
+        pick->best_lag = peak_lag;
+        pick->best = pick->prev1;
+    }
+
+    pick->prev2 = pick->prev1;
+    pick->prev1 = r;
+}
+
+/*!
+ * @brief Integer mean of the signal.
+ */
+static int32_t ac_mean(const int16_t signal[], int32_t length)
+{
+    int64_t sum = 0;
+    int32_t i;
+
+    for (i = 0; i < length; i++) {
+        sum += signal[i];
+    }
+
+    return (int32_t)(sum / length);
+}
+
+/*!
+ * @brief Direct biased autocorrelation at one lag (int64 accumulator).
+ */
+static int64_t ac_direct(const int16_t signal[], int32_t length, int32_t mean, int32_t lag)
+{
+    int64_t sum = 0;
+    int32_t i;
+
+    for (i = 0; (i + lag) < length; i++) {
+        sum += (int64_t)(signal[i] - mean) * (int64_t)(signal[i + lag] - mean);
+    }
+
+    return sum;
+}
+
+/*!
+ * @brief cos and sin of 2*pi*k/n in Q2.30 (n power of two >= 8, 0 <= k < n/2).
+ */
+static void ac_twiddle(int32_t k, int32_t n, int32_t *cos_q30, int32_t *sin_q30)
+{
+    int32_t a = k;
+    bool negate_cos = false;
+    bool swap = false;
+    int64_t x;
+    int64_t x2;
+    int64_t t;
+    int64_t s;
+    int64_t c;
+
+    if ((4 * a) > n) {
+        a = (n / 2) - a;     /* theta > pi/2: use pi - theta */
+        negate_cos = true;
+    }
+    if ((8 * a) > n) {
+        a = (n / 4) - a;     /* theta > pi/4: use pi/2 - theta */
+        swap = true;
+    }
+
+    x = (AC_TWO_PI_Q30 * a) / n;
+    x2 = (x * x) >> 30;
+
+    t = AC_Q30_ONE - (x2 / 72);
+    t = AC_Q30_ONE - (((x2 * t) >> 30) / 42);
+    t = AC_Q30_ONE - (((x2 * t) >> 30) / 20);
+    t = AC_Q30_ONE - (((x2 * t) >> 30) / 6);
+    s = (x * t) >> 30;
+
+    t = AC_Q30_ONE - (x2 / 90);
+    t = AC_Q30_ONE - (((x2 * t) >> 30) / 56);
+    t = AC_Q30_ONE - (((x2 * t) >> 30) / 30);
+    t = AC_Q30_ONE - (((x2 * t) >> 30) / 12);
+    c = AC_Q30_ONE - (((x2 * t) >> 30) / 2);
+
+    if (swap) {
+        t = s;
+        s = c;
+        c = t;
+    }
+
+    *cos_q30 = (int32_t)(negate_cos ? -c : c);
+    *sin_q30 = (int32_t)s;
+}
+
+/*!
+ * @brief Halve the block until every component is below AC_BFP_LIMIT.
+ */
+static void ac_normalise(int32_t data[], int32_t n)
+{
+    int32_t max = 0;
+    int32_t shift = 0;
+    int32_t i;
+
+    for (i = 0; i < (2 * n); i++) {
+        int32_t m = (data[i] < 0) ? -data[i] : data[i];
+        max = (m > max) ? m : max;
+    }
+
+    while ((max >> shift) >= AC_BFP_LIMIT) {
+        shift++;
+    }
+
+    if (shift > 0) {
+        for (i = 0; i < (2 * n); i++) {
+            data[i] >>= shift;
+        }
+    }
+}
+
+/*!
+ * @brief In-place radix-2 complex FFT on interleaved (re, im) data.
+ *
+ * @param data 2 * n entries
+ * @param n Transform size (power of two >= 8)
+ * @param inverse true for the inverse direction (no 1/n scaling)
+ */
+static void ac_fft(int32_t data[], int32_t n, bool inverse)
+{
+    int32_t i;
+    int32_t j = 0;
+    int32_t half;
+
+    /* Bit-reversal permutation */
+    for (i = 0; i < (n - 1); i++) {
+        int32_t bit;
+
+        if (i < j) {
+            int32_t t_re = data[2 * i];
+            int32_t t_im = data[(2 * i) + 1];
+
+            data[2 * i] = data[2 * j];
+            data[(2 * i) + 1] = data[(2 * j) + 1];
+            data[2 * j] = t_re;
+            data[(2 * j) + 1] = t_im;
+        }
+        bit = n / 2;
+        while ((j & bit) != 0) {
+            j ^= bit;
+            bit /= 2;
+        }
+        j |= bit;
+    }
+
+    for (half = 1; half < n; half *= 2) {
+        int32_t step = n / (2 * half);
+        int32_t k;
+
+        ac_normalise(data, n);
+
+        for (k = 0; k < half; k++) {
+            int32_t w_re;
+            int32_t w_im;
+            int32_t start;
+
+            ac_twiddle(k * step, n, &w_re, &w_im);
+            w_im = inverse ? w_im : -w_im;   /* Forward: exp(-i theta) */
+
+            for (start = k; start < n; start += 2 * half) {
+                int32_t a = 2 * start;
+                int32_t b = 2 * (start + half);
+                int32_t t_re = (int32_t)((((int64_t)w_re * data[b]) -
+                                          ((int64_t)w_im * data[b + 1])) >> 30);
+                int32_t t_im = (int32_t)((((int64_t)w_re * data[b + 1]) +
+                                          ((int64_t)w_im * data[b])) >> 30);
+
+                data[b] = data[a] - t_re;
+                data[b + 1] = data[a + 1] - t_im;
+                data[a] += t_re;
+                data[a + 1] += t_im;
+            }
+        }
+    }
+}
+
+/*!
+ * @brief Work buffer entries the FFT path needs.
+ *
+ * @param length Signal length
+ * @param max_lag Largest lag of interest
+ * @return 2 * N for the transform size N (power of two >= length + max_lag)
+ */
+int32_t peak_period_work_size(int32_t length, int32_t max_lag)
+{
+    int32_t n = 8;
+
+    while (n < (length + max_lag)) {
+        n *= 2;
+    }
+
+    return 2 * n;
+}
+
+/*!
+ * @brief Estimate the dominant period from the autocorrelation.
+ *
+ * Lag ranges up to PEAK_PERIOD_DIRECT_MAX_LAG, or calls without a work
+ * buffer, use the direct int64 sum; longer ones use the FFT.
+ *
+ * @param signal Input signal array
+ * @param length Signal length (3 .. 2^28)
+ * @param min_lag Smallest period to consider (>= 1)
+ * @param max_lag Largest period to consider (clamped to length - 1)
+ * @param work FFT work buffer (peak_period_work_size() entries), or NULL
+ * @param work_capacity Entries in work
+ * @param period Output: dominant period in samples
+ * @param strength_q16 Output (optional): r[period] / r[0] in Q16.16, near
+ *        1.0 for a clean periodic signal
+ * @return PEAK_FP_OK if a period was found, PEAK_FP_NO_PEAK_FOUND if the
+ *         autocorrelation has no positive local maximum in range
+ */
+PeakResultFP peak_period_estimate(const int16_t signal[],
+                                  int32_t length,
+                                  int32_t min_lag,
+                                  int32_t max_lag,
+                                  int32_t work[],
+                                  int32_t work_capacity,
+                                  int32_t *period,
+                                  int32_t *strength_q16)
+{
+    AcPick pick;
+    int32_t mean;
+    int64_t r0;
+    int32_t lag;
+    int32_t i;
+
+    if ((signal == NULL) || (period == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if ((length <= 0) || (length > (1L << 28)) || (min_lag < 1) || (max_lag < min_lag)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if (length < 3) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+
+    max_lag = (max_lag > (length - 1)) ? (length - 1) : max_lag;
+    if (max_lag < min_lag) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+
+    mean = ac_mean(signal, length);
+    pick.prev2 = 0;
+    pick.prev1 = 0;
+    pick.min_lag = min_lag;
+    pick.best_lag = -1;
+    pick.best = 0;
+
+    if ((work == NULL) || (max_lag <= PEAK_PERIOD_DIRECT_MAX_LAG)) {
+        r0 = ac_direct(signal, length, mean, 0);
+        for (lag = min_lag - 1; lag <= (max_lag + 1); lag++) {
+            ac_pick_push(&pick, lag, (lag == 0) ? r0 : ac_direct(signal, length, mean, lag));
+        }
+    } else {
+        int32_t size = peak_period_work_size(length, max_lag);
+        int32_t n = size / 2;
+        int64_t max_power = 0;
+        int32_t shift = 0;
+
+        if (work_capacity < size) {
+            return PEAK_FP_BUFFER_TOO_SMALL;
+        }
+
+        /* |x - mean| < 2^16: start just below the block limit */
+        for (i = 0; i < n; i++) {
+            work[2 * i] = (i < length) ? ((signal[i] - mean) * 4096) : 0;
+            work[(2 * i) + 1] = 0;
+        }
+
+        ac_fft(work, n, false);
+        ac_normalise(work, n);
+
+        /* |X|^2 (< 2^59), rescaled into the block range */
+        for (i = 0; i < n; i++) {
+            int64_t p = ((int64_t)work[2 * i] * work[2 * i]) +
+                        ((int64_t)work[(2 * i) + 1] * work[(2 * i) + 1]);
+            max_power = (p > max_power) ? p : max_power;
+        }
+        while ((max_power >> shift) >= AC_BFP_LIMIT) {
+            shift++;
+        }
+        for (i = 0; i < n; i++) {
+            int64_t p = ((int64_t)work[2 * i] * work[2 * i]) +
+                        ((int64_t)work[(2 * i) + 1] * work[(2 * i) + 1]);
+            work[2 * i] = (int32_t)(p >> shift);
+            work[(2 * i) + 1] = 0;
+        }
+
+        ac_fft(work, n, true);
+
+        r0 = work[0];
+        for (lag = min_lag - 1; lag <= (max_lag + 1); lag++) {
+            ac_pick_push(&pick, lag, work[2 * lag]);
+        }
+    }
+
+    if ((pick.best_lag < 0) || (r0 <= 0)) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+
+    *period = pick.best_lag;
+    if (strength_q16 != NULL) {
+        int64_t best = pick.best;
+
+        /* r0 reaches 2^60 for long full-scale input; scale both (best <= r0)
+         * so best * Q16_ONE fits int64. r0 stays >= 2^46, never 0 */
+        while (r0 >= ((int64_t)1 << 47)) {
+            r0 >>= 1;
+            best >>= 1;
+        }
+        *strength_q16 = (int32_t)((best * Q16_ONE) / r0);
+    }
+
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Estimate the period, then find one peak per period.
+ *
+ * Convenience wrapper: peak_period_estimate() followed by
+ * find_periodic_peaks_fp() with the estimated period.
+ *
+ * @return Result of the estimate if it fails, else of the peak search
+ */
+PeakResultFP find_peaks_autoperiod_fp(const int16_t signal[],
+                                      int32_t length,
+                                      int32_t min_lag,
+                                      int32_t max_lag,
+                                      int32_t work[],
+                                      int32_t work_capacity,
+                                      PeakInfoFP peaks[],
+                                      int32_t max_peaks,
+                                      int32_t *num_peaks,
+                                      const PeakConfigFP *user_config)
+{
+    int32_t period;
+    PeakResultFP result;
+
+    if (num_peaks == NULL) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    *num_peaks = 0;
+    result = peak_period_estimate(signal, length, min_lag, max_lag, work, work_capacity,
+                                  &period, NULL);
+    if (result != PEAK_FP_OK) {
+        return result;
+    }
+
+    return find_periodic_peaks_fp(signal, length, period, peaks, max_peaks, num_peaks,
+                                  user_config);
+}
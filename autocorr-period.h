@@ -0,0 +1,59 @@
+/*!
+ * Fixed-Point Autocorrelation Period Estimator
+ *
+ * Estimates the dominant period of a signal from its (biased)
+ * autocorrelation, so that find_periodic_peaks_fp() can restrict the
+ * peak search to one window per period.
+ *
+ * Short lag ranges are computed directly with int64 accumulators
+ * (O(n * max_lag)). Long ones go through a block-floating-point
+ * radix-2 FFT (Wiener-Khinchin, O(n log n)) in a caller-provided work
+ * buffer. Integer arithmetic only; no allocation.
+ */
+
+#ifndef AUTOCORR_PERIOD_H
+#define AUTOCORR_PERIOD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "embedded-signal-peaks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lag ranges up to this use the direct sum even when a work buffer is given */
+#ifndef PEAK_PERIOD_DIRECT_MAX_LAG
+#define PEAK_PERIOD_DIRECT_MAX_LAG (64)
+#endif
+
+/* Work buffer entries sufficient for the FFT path (upper bound) */
+#define PEAK_PERIOD_WORK(length, max_lag) (4 * ((length) + (max_lag)))
+
+int32_t peak_period_work_size(int32_t length, int32_t max_lag);
+
+PeakResultFP peak_period_estimate(const int16_t signal[],
+                                  int32_t length,
+                                  int32_t min_lag,
+                                  int32_t max_lag,
+                                  int32_t work[],
+                                  int32_t work_capacity,
+                                  int32_t *period,
+                                  int32_t *strength_q16);
+
+PeakResultFP find_peaks_autoperiod_fp(const int16_t signal[],
+                                      int32_t length,
+                                      int32_t min_lag,
+                                      int32_t max_lag,
+                                      int32_t work[],
+                                      int32_t work_capacity,
+                                      PeakInfoFP peaks[],
+                                      int32_t max_peaks,
+                                      int32_t *num_peaks,
+                                      const PeakConfigFP *user_config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AUTOCORR_PERIOD_H */
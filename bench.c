@@ -0,0 +1,580 @@
+/*!
+ * Benchmark Harness for embedded-signal-peaks
+ *
+ * Sweeps signal length, peak density, peak width and noise level over
+ * deterministic synthetic signals and times every public entry point.
+ * Results are written as JSON (one record per case) for regression
+ * tracking across versions.
+ *
+ * A --wcet mode replaces the sweep with adversarial inputs built to
+ * maximise candidate counts and contour-walk lengths, and reports the
+ * worst observed time together with operation counts. Building with
+ * -DPEAK_FP_ENABLE_STATS adds the library's per-stage cycle counters.
+ *
+ * Build: gcc -O2 -o bench bench.c embedded-signal-peaks.c signal-gen.c
+ * Usage: ./bench [--quick | --wcet] > bench_output.txt
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "embedded-signal-peaks.h"
+#include "signal-gen.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC (1)
+#else
+#define BENCH_HAVE_TSC (0)
+#endif
+
+/* Upper bound of the sweep and per-case timing budget */
+#define BENCH_MAX_LENGTH (1048576)
+#define BENCH_MAX_REPS (200)
+#define BENCH_TARGET_SAMPLES (4000000L)
+#define BENCH_MIN_BATCH_SAMPLES (4096)
+#define BENCH_WCET_REPS (1000)
+#define BENCH_WCET_MAX_LENGTH (16384)
+
+/* Detector format, reported with the results so builds can be compared */
+#if PEAK_FP_Q_FORMAT == PEAK_Q_24_8
+#define BENCH_Q_FORMAT "Q24.8"
+#elif PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+#define BENCH_Q_FORMAT "Q8.8"
+#elif PEAK_FP_Q_FORMAT == PEAK_Q_1_15
+#define BENCH_Q_FORMAT "Q1.15"
+#else
+#define BENCH_Q_FORMAT "Q16.16"
+#endif
+
+/* Bytes of the library's static working buffer in this format */
+#define BENCH_WORK_BYTES ((int32_t)(sizeof(peak_q_t) * MAX_SIGNAL_LENGTH))
+
+/* Shared buffers (largest case) */
+static int16_t s_signal[BENCH_MAX_LENGTH];
+static peak_q_t s_q16_buffer[MAX_SIGNAL_LENGTH];
+static uint32_t s_candidate_bitmap[PEAK_BITMAP_WORDS(MAX_SIGNAL_LENGTH)];
+static int16_t s_frame[MAX_SIGNAL_LENGTH];
+static uint64_t s_arena_memory[BENCH_MAX_LENGTH];  /* Room for length/2 peaks */
+static uint64_t s_ns[BENCH_WCET_REPS];
+static uint64_t s_cycles[BENCH_WCET_REPS];
+
+/* Defeats dead-code elimination of results */
+static volatile int32_t s_sink;
+
+/* Synthetic signal description */
+typedef struct {
+    int32_t length;
+    int32_t density;     /* Pulses per 1000 samples */
+    int32_t width;       /* Pulse width in samples (Gaussian, exp(-(t/w)^2)) */
+    int32_t noise;       /* Gaussian noise RMS (counts) */
+    uint32_t seed;
+} BenchSignal;
+
+/* Adversarial input patterns for WCET measurement */
+typedef enum {
+    ADV_SAWTOOTH_FLAT = 0, /* Candidate every third sample, equal heights */
+    ADV_STAIRCASE,         /* Rising zigzag: every left walk reaches index 0 */
+    ADV_MOUNTAIN,          /* Rising then falling zigzag: walks span to both edges */
+    ADV_LATE_STAIRCASE,    /* Low plateau, rising zigzag in the second half:
+                              each of the length/4 zigzag candidates walks
+                              left across the whole plateau */
+    ADV_COUNT
+} AdversarialPattern;
+
+static const char *const s_adv_names[ADV_COUNT] = {
+    "sawtooth_flat", "staircase", "mountain", "late_staircase"
+};
+
+/* Operation counts for one input (measured by re-walking every candidate) */
+typedef struct {
+    int32_t candidates;
+    int64_t walk_steps_left;
+    int64_t walk_steps_right;
+} BenchOpCount;
+
+/* Entry point under test */
+typedef struct {
+    const char *name;
+    int32_t max_length;  /* Longest signal the entry point accepts */
+    bool framed;         /* Detects whole frames of bench_frame_length() only */
+    void (*run)(int32_t length);
+} BenchEntry;
+
+/*!
+ * @brief Fill s_signal with a Gaussian pulse train, baseline and noise.
+ *
+ * Uses the integer-only signal generator, so signals are bit-identical
+ * on every platform. Generated in blocks to exercise the streaming path.
+ */
+static void generate_signal(const BenchSignal *sig)
+{
+    SignalGenConfig config;
+    SignalGen gen;
+    int32_t spacing = (sig->density > 0) ? (1000 / sig->density) : 0;
+    int32_t pos;
+
+    memset(&config, 0, sizeof(config));
+    config.seed = sig->seed;
+    config.baseline = 500;
+    config.pulse_shape = SIGNAL_PULSE_GAUSS;
+    config.pulse_amplitude = (spacing > 0) ? 200 : 0;
+    config.pulse_amplitude_spread = (spacing > 0) ? 800 : 0;
+    config.pulse_width = sig->width;
+    config.pulse_first = spacing / 2;
+    config.pulse_period = spacing;
+    config.pulse_jitter = spacing / 4;
+    config.noise_rms = sig->noise;
+
+    signal_gen_init(&gen, &config);
+    for (pos = 0; pos < sig->length; pos += BENCH_MIN_BATCH_SAMPLES) {
+        int32_t n = sig->length - pos;
+        signal_gen_block(&gen, &s_signal[pos], (n < BENCH_MIN_BATCH_SAMPLES) ? n : BENCH_MIN_BATCH_SAMPLES);
+    }
+
+#if PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+    /* Q8.8 takes 8-bit samples */
+    for (pos = 0; pos < sig->length; pos++) {
+        s_signal[pos] = (int16_t)(s_signal[pos] / 16);
+    }
+#endif
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t now_cycles(void)
+{
+#if BENCH_HAVE_TSC
+    return (uint64_t)__rdtsc();
+#else
+    return 0U;
+#endif
+}
+
+/* --- Entry point adapters ------------------------------------------------ */
+
+static void run_find(int32_t length)
+{
+    int32_t idx = -1;
+
+    (void)find_prominent_peak_fp(s_signal, length, &idx, NULL);
+    s_sink = idx;
+}
+
+static void run_buffered(int32_t length)
+{
+    int32_t idx = -1;
+
+    (void)find_prominent_peak_fp_buffered(s_signal, length, &idx, NULL,
+                                          s_q16_buffer, s_candidate_bitmap);
+    s_sink = idx;
+}
+
+static void run_pipeline(int32_t length)
+{
+    static const PeakPipelineFP pipeline = { 2, 6 };
+    int32_t idx = -1;
+
+    (void)find_prominent_peak_pipeline_fp(s_signal, length, &pipeline, &idx, NULL);
+    s_sink = idx;
+}
+
+static void run_iter_first(int32_t length)
+{
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+
+    peak.index = -1;
+    (void)peak_iter_init(&iter, s_signal, length, NULL);
+    (void)peak_iter_next(&iter, &peak);
+    s_sink = peak.index;
+}
+
+static void run_iter_all(int32_t length)
+{
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    int32_t count = 0;
+
+    (void)peak_iter_init(&iter, s_signal, length, NULL);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        count++;
+    }
+    s_sink = count;
+}
+
+static void run_arena(int32_t length)
+{
+    PeakArenaFP arena;
+    PeakListFP list;
+
+    peak_arena_init(&arena, s_arena_memory, sizeof(s_arena_memory));
+    (void)find_peaks_arena_fp(s_signal, length, NULL, &arena, &list);
+    s_sink = list.count;
+}
+
+/*!
+ * @brief Frame length of the framed entry points for a signal length.
+ *
+ * Short signals are one frame; longer ones are cut into
+ * MAX_SIGNAL_LENGTH frames, which only covers the whole signal when the
+ * length is a multiple of it (see bench_entry_applies()).
+ */
+static int32_t bench_frame_length(int32_t length)
+{
+    return (length < MAX_SIGNAL_LENGTH) ? length : MAX_SIGNAL_LENGTH;
+}
+
+static void run_stream(int32_t length)
+{
+    PeakStreamFP stream;
+    PeakInfoFP peak;
+    int32_t count = 0;
+
+    (void)peak_stream_init(&stream, s_frame, bench_frame_length(length), NULL);
+    (void)peak_stream_feed(&stream, s_signal, length);
+    while (peak_stream_next(&stream, &peak) == PEAK_FP_OK) {
+        count++;
+    }
+    s_sink = count;
+}
+
+static const BenchEntry s_entries[] = {
+    { "find_prominent_peak_fp", MAX_SIGNAL_LENGTH, false, run_find },
+    { "find_prominent_peak_fp_buffered", MAX_SIGNAL_LENGTH, false, run_buffered },
+    { "find_prominent_peak_pipeline_fp", MAX_SIGNAL_LENGTH, false, run_pipeline },
+    { "peak_iter_first", BENCH_MAX_LENGTH, false, run_iter_first },
+    { "peak_iter_all", BENCH_MAX_LENGTH, false, run_iter_all },
+    { "find_peaks_arena_fp", BENCH_MAX_LENGTH, false, run_arena },
+    { "peak_stream", BENCH_MAX_LENGTH, true, run_stream }
+};
+
+/*!
+ * @brief True if an entry point processes every sample of a signal length.
+ *
+ * Framed entries leave a trailing partial frame unscanned, so they are
+ * only reported for lengths made of whole frames.
+ */
+static bool bench_entry_applies(const BenchEntry *entry, int32_t length)
+{
+    return (length <= entry->max_length) &&
+           (!entry->framed || ((length % bench_frame_length(length)) == 0));
+}
+
+/* --- Measurement ---------------------------------------------------------- */
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*!
+ * @brief Value at percentile pct (0..100) of a sorted array.
+ */
+static uint64_t percentile(const uint64_t sorted[], int32_t n, int32_t pct)
+{
+    int32_t rank = (n * pct + 99) / 100;
+
+    return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+/*!
+ * @brief Time one entry point on the current signal and emit a JSON record.
+ */
+static void bench_case(const BenchEntry *entry, const BenchSignal *sig, bool *first)
+{
+    int32_t length = sig->length;
+    int32_t batch = (length < BENCH_MIN_BATCH_SAMPLES) ? (BENCH_MIN_BATCH_SAMPLES / length) : 1;
+    long budget = BENCH_TARGET_SAMPLES / ((long)length * batch);
+    int32_t reps = (budget > BENCH_MAX_REPS) ? BENCH_MAX_REPS : ((budget < 5) ? 5 : (int32_t)budget);
+    int32_t r;
+    int32_t b;
+
+    entry->run(length);  /* Warm-up */
+
+    for (r = 0; r < reps; r++) {
+        uint64_t t0 = now_ns();
+        uint64_t c0 = now_cycles();
+        for (b = 0; b < batch; b++) {
+            entry->run(length);
+        }
+        s_cycles[r] = (now_cycles() - c0) / (uint64_t)batch;
+        s_ns[r] = (now_ns() - t0) / (uint64_t)batch;
+    }
+
+    qsort(s_ns, (size_t)reps, sizeof(s_ns[0]), compare_u64);
+    qsort(s_cycles, (size_t)reps, sizeof(s_cycles[0]), compare_u64);
+
+    printf("%s    {\"entry\": \"%s\", \"length\": %d, \"density\": %d, "
+           "\"width\": %d, \"noise\": %d, \"reps\": %d, \"batch\": %d, "
+           "\"ns_per_sample\": %.3f, \"median_ns\": %llu, \"p99_ns\": %llu, "
+           "\"min_ns\": %llu, \"median_cycles\": %llu}",
+           *first ? "" : ",\n",
+           entry->name, length, sig->density, sig->width, sig->noise, reps, batch,
+           (double)percentile(s_ns, reps, 50) / (double)length,
+           (unsigned long long)percentile(s_ns, reps, 50),
+           (unsigned long long)percentile(s_ns, reps, 99),
+           (unsigned long long)s_ns[0],
+           (unsigned long long)percentile(s_cycles, reps, 50));
+    fflush(stdout);
+    *first = false;
+}
+
+/* --- Adversarial inputs (WCET) ------------------------------------------- */
+
+/*!
+ * @brief Fill s_signal with an adversarial pattern.
+ *
+ * Heights stay within int16_t and above the default noise floor; the
+ * zigzag amplitude is well above the default gradient threshold.
+ */
+static void generate_adversarial(AdversarialPattern pattern, int32_t length)
+{
+    int32_t i;
+    int32_t half = length / 2;
+    int32_t slope = 30000 / length;  /* Rise per sample, kept below the bump */
+
+    slope = (slope > 7) ? 7 : ((slope < 1) ? 1 : slope);
+
+    for (i = 0; i < length; i++) {
+        int32_t bump = ((i % 2) == 1) ? 8 : 0;
+        int32_t level;
+
+        switch (pattern) {
+        case ADV_STAIRCASE:
+            level = i * slope;
+            break;
+        case ADV_MOUNTAIN:
+            level = ((i < half) ? i : (length - 1 - i)) * slope;
+            break;
+        case ADV_LATE_STAIRCASE:
+            level = (i < half) ? 0 : ((i - half) * slope);
+            bump = (i < half) ? 0 : bump;
+            break;
+        case ADV_SAWTOOTH_FLAT:
+        default:
+            /* Period 3 keeps the central-difference gradient non-zero */
+            level = (i % 3) * 8;
+            bump = 0;
+            break;
+        }
+        s_signal[i] = (int16_t)(100 + level + bump);
+    }
+}
+
+/*!
+ * @brief Count candidates and contour-walk steps for the current signal.
+ *
+ * Candidates are enumerated with the library's own iterator (a zero
+ * prominence threshold makes it yield every candidate); each walk is
+ * then replayed to count the samples it visits.
+ *
+ * @param length Signal length
+ * @param ops Output: operation counts
+ */
+static void count_operations(int32_t length, BenchOpCount *ops)
+{
+    PeakConfigFP config = { 0, GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    int32_t i;
+
+    ops->candidates = 0;
+    ops->walk_steps_left = 0;
+    ops->walk_steps_right = 0;
+
+    (void)peak_iter_init(&iter, s_signal, length, &config);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        ops->candidates++;
+        for (i = peak.index - 1; (i >= 0) && (s_signal[i] < peak.value); i--) {
+            ops->walk_steps_left++;
+        }
+        for (i = peak.index + 1; (i < length) && (s_signal[i] < peak.value); i++) {
+            ops->walk_steps_right++;
+        }
+    }
+}
+
+/*!
+ * @brief Time one entry point on the current adversarial input.
+ *
+ * Runs BENCH_WCET_REPS unbatched calls and reports the maximum observed
+ * time and cycle count alongside the median and p99.
+ */
+static void wcet_case(const BenchEntry *entry, AdversarialPattern pattern,
+                      int32_t length, bool *first)
+{
+    BenchOpCount ops;
+    int32_t reps = (length > 4096) ? (BENCH_WCET_REPS / 50) : BENCH_WCET_REPS;
+    int32_t r;
+    char stage[160];
+
+    count_operations(length, &ops);
+
+    entry->run(length);  /* Warm-up */
+
+    for (r = 0; r < reps; r++) {
+        uint64_t t0 = now_ns();
+        uint64_t c0 = now_cycles();
+        entry->run(length);
+        s_cycles[r] = now_cycles() - c0;
+        s_ns[r] = now_ns() - t0;
+    }
+
+    qsort(s_ns, (size_t)reps, sizeof(s_ns[0]), compare_u64);
+    qsort(s_cycles, (size_t)reps, sizeof(s_cycles[0]), compare_u64);
+
+    stage[0] = '\0';
+#ifdef PEAK_FP_ENABLE_STATS
+    if (entry->max_length == MAX_SIGNAL_LENGTH) {
+        PeakStatsFP stats;
+
+        /* Library counters of the last call (frame entry points only) */
+        peak_fp_get_stats(&stats);
+        (void)snprintf(stage, sizeof(stage),
+                       ", \"stage_cycles\": {\"convert\": %u, \"candidates\": %u, "
+                       "\"prominence\": %u}",
+                       stats.cycles_convert, stats.cycles_candidates,
+                       stats.cycles_prominence);
+    }
+#endif
+
+    printf("%s    {\"entry\": \"%s\", \"pattern\": \"%s\", \"length\": %d, "
+           "\"reps\": %d, \"candidates\": %d, \"walk_steps_left\": %lld, "
+           "\"walk_steps_right\": %lld, \"median_ns\": %llu, \"p99_ns\": %llu, "
+           "\"max_ns\": %llu, \"median_cycles\": %llu, \"max_cycles\": %llu%s}",
+           *first ? "" : ",\n",
+           entry->name, s_adv_names[pattern], length, reps, ops.candidates,
+           (long long)ops.walk_steps_left, (long long)ops.walk_steps_right,
+           (unsigned long long)percentile(s_ns, reps, 50),
+           (unsigned long long)percentile(s_ns, reps, 99),
+           (unsigned long long)s_ns[reps - 1],
+           (unsigned long long)percentile(s_cycles, reps, 50),
+           (unsigned long long)s_cycles[reps - 1], stage);
+    fflush(stdout);
+    *first = false;
+}
+
+static void run_wcet(void)
+{
+    static const int32_t lengths[] = { 64, 256, 512, 4096, BENCH_WCET_MAX_LENGTH };
+    bool first = true;
+    size_t li;
+    size_t e;
+    int32_t p;
+
+    printf("{\n  \"version\": 2,\n  \"mode\": \"wcet\",\n  \"max_signal_length\": %d,\n"
+           "  \"q_format\": \"%s\",\n  \"work_bytes\": %d,\n"
+           "  \"tsc\": %s,\n  \"results\": [\n",
+           MAX_SIGNAL_LENGTH, BENCH_Q_FORMAT, BENCH_WORK_BYTES,
+           BENCH_HAVE_TSC ? "true" : "false");
+
+    for (p = 0; p < (int32_t)ADV_COUNT; p++) {
+        for (li = 0; li < sizeof(lengths) / sizeof(lengths[0]); li++) {
+            generate_adversarial((AdversarialPattern)p, lengths[li]);
+
+            for (e = 0; e < sizeof(s_entries) / sizeof(s_entries[0]); e++) {
+                if (bench_entry_applies(&s_entries[e], lengths[li])) {
+                    wcet_case(&s_entries[e], (AdversarialPattern)p, lengths[li], &first);
+                }
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+}
+
+/* --- Sweep ---------------------------------------------------------------- */
+
+static void run_sweep(bool quick)
+{
+    static const int32_t lengths[] = { 64, 256, 512, 4096, 65536, 1048576 };
+    static const int32_t densities[] = { 1, 10, 50 };
+    static const int32_t widths[] = { 4, 32 };
+    static const int32_t noises[] = { 0, 20 };
+    int32_t num_lengths = (int32_t)(sizeof(lengths) / sizeof(lengths[0]));
+    bool first = true;
+    size_t e;
+
+    if (quick) {
+        num_lengths = 4;  /* Up to 4096 samples */
+    }
+
+    printf("{\n  \"version\": 2,\n  \"max_signal_length\": %d,\n"
+           "  \"q_format\": \"%s\",\n  \"work_bytes\": %d,\n"
+           "  \"results\": [\n",
+           MAX_SIGNAL_LENGTH, BENCH_Q_FORMAT, BENCH_WORK_BYTES);
+    for (int32_t li = 0; li < num_lengths; li++) {
+        for (size_t di = 0; di < sizeof(densities) / sizeof(densities[0]); di++) {
+            for (size_t wi = 0; wi < sizeof(widths) / sizeof(widths[0]); wi++) {
+                for (size_t ni = 0; ni < sizeof(noises) / sizeof(noises[0]); ni++) {
+                    BenchSignal sig;
+
+                    sig.length = lengths[li];
+                    sig.density = densities[di];
+                    sig.width = widths[wi];
+                    sig.noise = noises[ni];
+                    sig.seed = 0x9E3779B9U ^ (uint32_t)(li * 131 + (int32_t)di * 17 +
+                                                        (int32_t)wi * 7 + (int32_t)ni);
+                    generate_signal(&sig);
+
+                    for (e = 0; e < sizeof(s_entries) / sizeof(s_entries[0]); e++) {
+                        if (bench_entry_applies(&s_entries[e], sig.length)) {
+                            bench_case(&s_entries[e], &sig, &first);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("\n  ]\n}\n");
+}
+
+static void usage(FILE *out, const char *program)
+{
+    fprintf(out, "usage: %s [--quick | --wcet]\n"
+                 "  (none)   full sweep, lengths 64 to %d\n"
+                 "  --quick  sweep up to 4096 samples\n"
+                 "  --wcet   adversarial inputs, worst-case times\n",
+            program, BENCH_MAX_LENGTH);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *mode = (argc > 1) ? argv[1] : "";
+
+    if ((argc == 2) && ((strcmp(mode, "--help") == 0) || (strcmp(mode, "-h") == 0))) {
+        usage(stdout, argv[0]);
+        return 0;
+    }
+
+    if ((argc > 2) || ((argc == 2) && (strcmp(mode, "--wcet") != 0) &&
+                       (strcmp(mode, "--quick") != 0))) {
+        usage(stderr, argv[0]);
+        return 2;
+    }
+
+    if (strcmp(mode, "--wcet") == 0) {
+        run_wcet();
+    } else {
+        run_sweep(strcmp(mode, "--quick") == 0);
+    }
+
+    return 0;
+}
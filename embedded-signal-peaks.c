@@ -10,36 +10,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <limits.h>
-
-/* Q16.16 Fixed-Point Configuration */
-#define Q16_SHIFT (16)
-#define Q16_ONE (1L << Q16_SHIFT)
-#define Q16_HALF (1L << (Q16_SHIFT - 1))
-
-/* Buffer sizes - adjust for your system */
-#define MAX_SIGNAL_LENGTH (512)
-#define MAX_PEAKS (32)
-
-/* Configuration constants (Q16.16 format) */
-#define PROMINENCE_THRESHOLD_Q16 ((int32_t)(1.0f * Q16_ONE))
-#define GRADIENT_THRESHOLD_Q16 ((int32_t)(0.1f * Q16_ONE))
-#define NOISE_FLOOR_Q16 ((int32_t)(10.0f * Q16_ONE))
-
-/* Return codes */
-typedef enum {
-    PEAK_FP_OK = 0,
-    PEAK_FP_NO_PEAK_FOUND = 1,
-    PEAK_FP_INVALID_INPUT = 2,
-    PEAK_FP_BUFFER_TOO_SMALL = 3
-} PeakResultFP;
-
-/* Configuration struct */
-typedef struct {
-    int32_t prominence_threshold_q16;
-    int32_t gradient_threshold_q16;
-    int32_t noise_floor_q16;
-} PeakConfigFP;
+#include "embedded-signal-peaks.h"
 
 /* Default configuration */
 static const PeakConfigFP default_config_fp = {
@@ -48,24 +21,124 @@ static const PeakConfigFP default_config_fp = {
     NOISE_FLOOR_Q16
 };
 
+_Static_assert(GRADIENT_THRESHOLD_Q16 > 0,
+               "default gradient threshold must be at least 1 LSB");
+
+/* Optional instrumentation: expands to nothing unless PEAK_FP_ENABLE_STATS */
+#ifdef PEAK_FP_ENABLE_STATS
+static PeakStatsFP s_stats;
+#define STATS_RESET()           (s_stats = s_stats_zero)
+#define STATS_ADD(field, n)     (s_stats.field += (n))
+#define STATS_MARK(var)         uint32_t var = PEAK_FP_CYCLES()
+#define STATS_ELAPSED(field, t) (s_stats.field += PEAK_FP_CYCLES() - (t))
+static const PeakStatsFP s_stats_zero = { 0U, 0U, 0U, 0, 0, 0 };
+#else
+#define STATS_RESET()
+#define STATS_ADD(field, n)
+#define STATS_MARK(var)
+#define STATS_ELAPSED(field, t)
+#endif
+
+/* Extra fraction bits of the detrend baseline: every format tracks it to
+ * 1/65536 sample step, so the floor of >> cannot drift it by an LSB per
+ * sample in the coarse formats (none needed for Q16.16) */
+#define PIPE_BASELINE_EXTRA (16 - PEAK_Q_SAMPLE_SHIFT)
+
 /* Static buffers to reduce stack usage */
-static int32_t s_signal_q16[MAX_SIGNAL_LENGTH];
-static int32_t s_peak_candidates[MAX_PEAKS];
+static peak_q_t s_signal_q16[MAX_SIGNAL_LENGTH];
+static uint32_t s_candidates[PEAK_BITMAP_WORDS(MAX_SIGNAL_LENGTH)];
+
+/*!
+ * @brief Clamp a detector-format value to the range of peak_q_t.
+ *
+ * A no-op for the int32 formats; Q8.8 clips detrended values outside
+ * the int16 range.
+ */
+static inline int32_t q_narrow(int32_t value)
+{
+#if PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+#endif
+    return value;
+}
+
+/*!
+ * @brief A sample as every detector path sees it.
+ *
+ * A no-op except under Q8.8, which clamps samples to -128..127. The raw
+ * paths compare samples through this so that they order and report them
+ * exactly as the converted frame paths do.
+ */
+static inline int16_t q_sample(int16_t value)
+{
+#if PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+    if (value > (INT16_MAX >> PEAK_Q_SAMPLE_SHIFT)) {
+        return (int16_t)(INT16_MAX >> PEAK_Q_SAMPLE_SHIFT);
+    }
+    if (value < (INT16_MIN >> PEAK_Q_SAMPLE_SHIFT)) {
+        return (int16_t)(INT16_MIN >> PEAK_Q_SAMPLE_SHIFT);
+    }
+#endif
+    return value;
+}
 
 /*!
- * @brief Convert int16_t to Q16.16 fixed-point format.
+ * @brief Convert int16_t to the detector Q format (Q16.16 by default).
  */
 static inline int32_t to_q16(int16_t value)
 {
-    return ((int32_t)value) << Q16_SHIFT;
+    return (int32_t)q_sample(value) * (int32_t)PEAK_Q_SAMPLE_ONE;
+}
+
+/*!
+ * @brief Clamp a widened detector-format value to +/-INT32_MAX.
+ *
+ * Full-scale int16 differences reach 65535.0, which does not fit Q16.16.
+ * The range is symmetric so that a saturated gradient can be negated.
+ */
+static inline int32_t q16_saturate(int64_t value)
+{
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < -INT32_MAX) {
+        return -INT32_MAX;
+    }
+    return (int32_t)value;
+}
+
+/*!
+ * @brief Saturating Q16.16 difference a - b.
+ */
+static inline int32_t q16_sub_sat(int32_t a, int32_t b)
+{
+    return q16_saturate((int64_t)a - (int64_t)b);
+}
+
+/*!
+ * @brief Central-difference gradient (a - b) / 2, widened before the shift.
+ */
+static inline int32_t q16_half_diff(int32_t a, int32_t b)
+{
+    return q16_saturate(((int64_t)a - (int64_t)b) >> 1);
 }
 
 /*!
- * @brief Convert Q16.16 back to int16_t (with rounding).
+ * @brief Convert the detector Q format back to int16_t (with rounding).
  */
 static inline int16_t from_q16(int32_t value_q16)
 {
-    int32_t rounded = (value_q16 + Q16_HALF) >> Q16_SHIFT;
+#if PEAK_Q_SAMPLE_SHIFT > 0
+    int32_t rounded = (int32_t)(((int64_t)value_q16 + (1L << (PEAK_Q_SAMPLE_SHIFT - 1))) >>
+                                PEAK_Q_SAMPLE_SHIFT);
+#else
+    int32_t rounded = value_q16;
+#endif
     
     if (rounded > INT16_MAX) {
         rounded = INT16_MAX;
@@ -76,6 +149,23 @@ static inline int16_t from_q16(int32_t value_q16)
     return (int16_t)rounded;
 }
 
+/*!
+ * @brief Index of the lowest set bit of a non-zero word.
+ */
+static inline int32_t bit_ctz32(uint32_t word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return (int32_t)__builtin_ctz(word);
+#else
+    static const uint8_t debruijn[32] = {
+        0U, 1U, 28U, 2U, 29U, 14U, 24U, 3U, 30U, 22U, 20U, 15U, 25U, 17U, 4U, 8U,
+        31U, 27U, 13U, 23U, 21U, 19U, 16U, 7U, 26U, 12U, 18U, 6U, 11U, 5U, 10U, 9U
+    };
+    
+    return (int32_t)debruijn[((word & (0U - word)) * 0x077CB531U) >> 27];
+#endif
+}
+
 /*!
  * @brief Calculate gradient at a point using central difference.
  * 
@@ -87,7 +177,7 @@ static inline int16_t from_q16(int32_t value_q16)
  * @param index Point to calculate gradient at
  * @return Gradient in Q16.16 format
  */
-static int32_t compute_gradient_at(const int32_t signal_q16[], 
+static int32_t compute_gradient_at(const peak_q_t signal_q16[], 
                                     int32_t length, 
                                     int32_t index)
 {
@@ -95,20 +185,20 @@ static int32_t compute_gradient_at(const int32_t signal_q16[],
     
     if (index == 0) {
         /* Forward difference */
-        grad = signal_q16[1] - signal_q16[0];
+        grad = q16_sub_sat(signal_q16[1], signal_q16[0]);
     } else if (index == (length - 1)) {
         /* Backward difference */
-        grad = signal_q16[length - 1] - signal_q16[length - 2];
+        grad = q16_sub_sat(signal_q16[length - 1], signal_q16[length - 2]);
     } else {
         /* Central difference, divide by 2 */
-        grad = (signal_q16[index + 1] - signal_q16[index - 1]) >> 1;
+        grad = q16_half_diff(signal_q16[index + 1], signal_q16[index - 1]);
     }
     
     return grad;
 }
 
 /*!
- * @brief Calculate MATLAB-compatible topological prominence.
+ * @brief Reference level of MATLAB-compatible topological prominence.
  *
  * True algorithm:
  * 1. Walk left until finding a higher peak or reaching boundary, track minimum
@@ -118,11 +208,11 @@ static int32_t compute_gradient_at(const int32_t signal_q16[],
  * @param signal_q16 Signal array (Q16.16)
  * @param length Signal length
  * @param peak_idx Peak index
- * @return Prominence in Q16.16 format
+ * @return max(left_minimum, right_minimum) in Q16.16 format
  */
-static int32_t calculate_topological_prominence(const int32_t signal_q16[],
-                                                 int32_t length,
-                                                 int32_t peak_idx)
+static int32_t topological_ref_level(const peak_q_t signal_q16[],
+                                     int32_t length,
+                                     int32_t peak_idx)
 {
     int32_t peak_value = signal_q16[peak_idx];
     int32_t left_min = peak_value;
@@ -141,6 +231,8 @@ static int32_t calculate_topological_prominence(const int32_t signal_q16[],
         }
     }
     
+    STATS_ADD(walk_steps_left, peak_idx - 1 - i);
+    
     /* Walk right contour: stop at higher peak or boundary */
     for (i = peak_idx + 1; i < length; i++) {
         if (signal_q16[i] >= peak_value) {
@@ -152,10 +244,27 @@ static int32_t calculate_topological_prominence(const int32_t signal_q16[],
         }
     }
     
+    STATS_ADD(walk_steps_right, i - peak_idx - 1);
+    
     /* Reference level is the higher of the two minima */
     ref_level = (left_min > right_min) ? left_min : right_min;
     
-    return peak_value - ref_level;
+    return ref_level;
+}
+
+/*!
+ * @brief Calculate MATLAB-compatible topological prominence.
+ *
+ * @param signal_q16 Signal array (Q16.16)
+ * @param length Signal length
+ * @param peak_idx Peak index
+ * @return Prominence in Q16.16 format, saturated at INT32_MAX
+ */
+static int32_t calculate_topological_prominence(const peak_q_t signal_q16[],
+                                                 int32_t length,
+                                                 int32_t peak_idx)
+{
+    return q16_sub_sat(signal_q16[peak_idx], topological_ref_level(signal_q16, length, peak_idx));
 }
 
 /*!
@@ -166,19 +275,20 @@ static int32_t calculate_topological_prominence(const int32_t signal_q16[],
  * 2. Point is above noise floor
  * 3. Gradient magnitude exceeds threshold
  *
+ * Candidates are marked in a bitmap (bit i of word i / 32), so there
+ * is no limit on their number.
+ *
  * @param signal_q16 Input signal (Q16.16)
  * @param length Signal length
  * @param config Configuration parameters
- * @param peak_indices Output array for peak indices
- * @param max_peaks Maximum number of peaks to find
- * @param num_peaks Output: number of peaks found
+ * @param candidates Output bitmap (PEAK_BITMAP_WORDS(length) words)
+ * @param num_peaks Output: number of candidates marked
  * @return PEAK_FP_OK on success
  */
-static PeakResultFP find_peak_candidates(const int32_t signal_q16[],
+static PeakResultFP find_peak_candidates(const peak_q_t signal_q16[],
                                           int32_t length,
                                           const PeakConfigFP *config,
-                                          int32_t peak_indices[],
-                                          int32_t max_peaks,
+                                          uint32_t candidates[],
                                           int32_t *num_peaks)
 {
     int32_t i;
@@ -192,6 +302,10 @@ static PeakResultFP find_peak_candidates(const int32_t signal_q16[],
         return PEAK_FP_BUFFER_TOO_SMALL;
     }
     
+    for (i = 0; i < PEAK_BITMAP_WORDS(length); i++) {
+        candidates[i] = 0U;
+    }
+    
     /* Compute initial gradient */
     grad_prev = compute_gradient_at(signal_q16, length, 0);
     
@@ -215,17 +329,14 @@ static PeakResultFP find_peak_candidates(const int32_t signal_q16[],
         bool strong_gradient = (grad_mag >= config->gradient_threshold_q16);
         
         if ((is_zero_crossing || is_local_max) && above_noise && strong_gradient) {
-            if (count < max_peaks) {
-                peak_indices[count] = i;
-                count++;
-            } else {
-                break;  /* Peak buffer full */
-            }
+            candidates[i / 32] |= 1U << (i % 32);
+            count++;
         }
         
         grad_prev = grad_curr;
     }
     
+    STATS_ADD(candidates_found, count);
     *num_peaks = count;
     return PEAK_FP_OK;
 }
@@ -233,37 +344,44 @@ static PeakResultFP find_peak_candidates(const int32_t signal_q16[],
 /*!
  * @brief Select the most prominent peak from candidates.
  *
+ * Candidates are visited in index order, one count-trailing-zeros per
+ * set bit; empty words cost a single test.
+ *
  * @param signal_q16 Signal array (Q16.16)
  * @param length Signal length
- * @param peak_indices Array of candidate peak indices
- * @param num_peaks Number of candidate peaks
+ * @param candidates Candidate bitmap from find_peak_candidates()
  * @param config Configuration parameters
  * @param best_peak_idx Output: index of most prominent peak
  * @param best_prominence Output: prominence value (optional, can be NULL)
  * @return PEAK_FP_OK if valid peak found
  */
-static PeakResultFP select_prominent_peak(const int32_t signal_q16[],
+static PeakResultFP select_prominent_peak(const peak_q_t signal_q16[],
                                            int32_t length,
-                                           const int32_t peak_indices[],
-                                           int32_t num_peaks,
+                                           const uint32_t candidates[],
                                            const PeakConfigFP *config,
                                            int32_t *best_peak_idx,
                                            int32_t *best_prominence)
 {
-    int32_t i;
+    int32_t w;
     int32_t max_prominence = INT32_MIN;
     int32_t best_idx = -1;
     
     /* Evaluate each candidate peak */
-    for (i = 0; i < num_peaks; i++) {
-        int32_t idx = peak_indices[i];
-        int32_t prominence = calculate_topological_prominence(signal_q16, length, idx);
+    for (w = 0; w < PEAK_BITMAP_WORDS(length); w++) {
+        uint32_t bits = candidates[w];
         
-        /* Keep track of most prominent peak above threshold */
-        if ((prominence >= config->prominence_threshold_q16) && 
-            (prominence > max_prominence)) {
-            max_prominence = prominence;
-            best_idx = idx;
+        while (bits != 0U) {
+            int32_t idx = (w * 32) + bit_ctz32(bits);
+            int32_t prominence = calculate_topological_prominence(signal_q16, length, idx);
+            
+            bits &= bits - 1U;
+            
+            /* Keep track of most prominent peak above threshold */
+            if ((prominence >= config->prominence_threshold_q16) && 
+                (prominence > max_prominence)) {
+                max_prominence = prominence;
+                best_idx = idx;
+            }
         }
     }
     
@@ -312,13 +430,17 @@ PeakResultFP find_prominent_peak_fp(const int16_t signal[],
     config = (user_config != NULL) ? user_config : &default_config_fp;
     
     /* Convert input signal to Q16.16 (use static buffer) */
+    STATS_RESET();
+    STATS_MARK(t_stage);
     for (i = 0; i < length; i++) {
-        s_signal_q16[i] = to_q16(signal[i]);
+        s_signal_q16[i] = (peak_q_t)to_q16(signal[i]);
     }
+    STATS_ELAPSED(cycles_convert, t_stage);
     
     /* Find peak candidates using gradient analysis */
-    result = find_peak_candidates(s_signal_q16, length, config,
-                                   s_peak_candidates, MAX_PEAKS, &num_candidates);
+    STATS_MARK(t_candidates);
+    result = find_peak_candidates(s_signal_q16, length, config, s_candidates, &num_candidates);
+    STATS_ELAPSED(cycles_candidates, t_candidates);
     if (result != PEAK_FP_OK) {
         return result;
     }
@@ -328,8 +450,10 @@ PeakResultFP find_prominent_peak_fp(const int16_t signal[],
     }
     
     /* Select most prominent peak using topological prominence */
-    result = select_prominent_peak(s_signal_q16, length, s_peak_candidates,
-                                    num_candidates, config, peak_index, NULL);
+    STATS_MARK(t_prominence);
+    result = select_prominent_peak(s_signal_q16, length, s_candidates,
+                                    config, peak_index, NULL);
+    STATS_ELAPSED(cycles_prominence, t_prominence);
     
     return result;
 }
@@ -345,15 +469,15 @@ PeakResultFP find_prominent_peak_fp(const int16_t signal[],
  * @param peak_index Output: index of detected peak
  * @param user_config Optional configuration
  * @param signal_q16_buffer Caller-provided buffer (length elements)
- * @param peaks_buffer Caller-provided buffer (MAX_PEAKS elements)
+ * @param candidate_bitmap Caller-provided buffer (PEAK_BITMAP_WORDS(length) words)
  * @return PEAK_FP_OK if peak found
  */
 PeakResultFP find_prominent_peak_fp_buffered(const int16_t signal[],
                                               int32_t length,
                                               int32_t *peak_index,
                                               const PeakConfigFP *user_config,
-                                              int32_t *signal_q16_buffer,
-                                              int32_t *peaks_buffer)
+                                              peak_q_t *signal_q16_buffer,
+                                              uint32_t *candidate_bitmap)
 {
     int32_t num_candidates;
     int32_t i;
@@ -362,7 +486,7 @@ PeakResultFP find_prominent_peak_fp_buffered(const int16_t signal[],
     
     /* Validate inputs */
     if ((signal == NULL) || (peak_index == NULL) || 
-        (signal_q16_buffer == NULL) || (peaks_buffer == NULL)) {
+        (signal_q16_buffer == NULL) || (candidate_bitmap == NULL)) {
         return PEAK_FP_INVALID_INPUT;
     }
     
@@ -373,13 +497,18 @@ PeakResultFP find_prominent_peak_fp_buffered(const int16_t signal[],
     config = (user_config != NULL) ? user_config : &default_config_fp;
     
     /* Convert input signal to Q16.16 */
+    STATS_RESET();
+    STATS_MARK(t_stage);
     for (i = 0; i < length; i++) {
-        signal_q16_buffer[i] = to_q16(signal[i]);
+        signal_q16_buffer[i] = (peak_q_t)to_q16(signal[i]);
     }
+    STATS_ELAPSED(cycles_convert, t_stage);
     
     /* Find peak candidates */
+    STATS_MARK(t_candidates);
     result = find_peak_candidates(signal_q16_buffer, length, config,
-                                   peaks_buffer, MAX_PEAKS, &num_candidates);
+                                   candidate_bitmap, &num_candidates);
+    STATS_ELAPSED(cycles_candidates, t_candidates);
     if (result != PEAK_FP_OK) {
         return result;
     }
@@ -389,38 +518,2172 @@ PeakResultFP find_prominent_peak_fp_buffered(const int16_t signal[],
     }
     
     /* Select most prominent peak */
-    result = select_prominent_peak(signal_q16_buffer, length, peaks_buffer,
-                                    num_candidates, config, peak_index, NULL);
+    STATS_MARK(t_prominence);
+    result = select_prominent_peak(signal_q16_buffer, length, candidate_bitmap,
+                                    config, peak_index, NULL);
+    STATS_ELAPSED(cycles_prominence, t_prominence);
     
     return result;
 }
 
 /*!
- * @brief Helper: Get peak prominence (for debugging/validation).
+ * @brief Find the most prominent peak in a signal split across two spans.
  *
- * @param signal Input signal
+ * The signal is head[0..head_length) followed by tail[0..tail_length),
+ * e.g. the last N samples of a wrapped ring or DMA buffer. Both spans are
+ * converted straight into the Q16.16 working buffer, so candidate
+ * detection and the prominence walks cross the seam without an
+ * intermediate linearising copy. Results are identical to
+ * find_prominent_peak_fp() on the concatenated signal.
+ *
+ * @param head First (older) span
+ * @param head_length Samples in head (may be 0)
+ * @param tail Second (newer) span (may be NULL if tail_length is 0)
+ * @param tail_length Samples in tail (may be 0)
+ * @param peak_index Output: index of detected peak, counted from head[0]
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK if peak found, error code otherwise
+ */
+PeakResultFP find_prominent_peak_fp_spans(const int16_t head[],
+                                           int32_t head_length,
+                                           const int16_t tail[],
+                                           int32_t tail_length,
+                                           int32_t *peak_index,
+                                           const PeakConfigFP *user_config)
+{
+    int32_t num_candidates;
+    int32_t length;
+    int32_t i;
+    PeakResultFP result;
+    const PeakConfigFP *config;
+    
+    /* Validate inputs */
+    if ((peak_index == NULL) || (head_length < 0) || (tail_length < 0) ||
+        ((head == NULL) && (head_length > 0)) || ((tail == NULL) && (tail_length > 0))) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if ((head_length > MAX_SIGNAL_LENGTH) || (tail_length > (MAX_SIGNAL_LENGTH - head_length))) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    length = head_length + tail_length;
+    if (length <= 0) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    config = (user_config != NULL) ? user_config : &default_config_fp;
+    
+    /* Convert both spans into one contiguous Q16.16 signal */
+    STATS_RESET();
+    STATS_MARK(t_stage);
+    for (i = 0; i < head_length; i++) {
+        s_signal_q16[i] = (peak_q_t)to_q16(head[i]);
+    }
+    for (i = 0; i < tail_length; i++) {
+        s_signal_q16[head_length + i] = (peak_q_t)to_q16(tail[i]);
+    }
+    STATS_ELAPSED(cycles_convert, t_stage);
+    
+    /* Find peak candidates using gradient analysis */
+    STATS_MARK(t_candidates);
+    result = find_peak_candidates(s_signal_q16, length, config, s_candidates, &num_candidates);
+    STATS_ELAPSED(cycles_candidates, t_candidates);
+    if (result != PEAK_FP_OK) {
+        return result;
+    }
+    
+    if (num_candidates == 0) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+    
+    /* Select most prominent peak using topological prominence */
+    STATS_MARK(t_prominence);
+    result = select_prominent_peak(s_signal_q16, length, s_candidates,
+                                    config, peak_index, NULL);
+    STATS_ELAPSED(cycles_prominence, t_prominence);
+    
+    return result;
+}
+
+/*!
+ * @brief Topological prominence on a periodic signal.
+ *
+ * Like calculate_topological_prominence(), but the contour walks wrap
+ * around the frame instead of stopping at its ends. Each walk covers at
+ * most length - 1 samples, so the highest peak sees the whole period and
+ * its prominence is its height above the global minimum.
+ *
+ * @param signal_q16 Signal array (Q16.16), one period
  * @param length Signal length
- * @param peak_index Peak index
- * @return Prominence as float
+ * @param peak_idx Peak index
+ * @return Prominence in Q16.16 format
  */
-float get_peak_prominence_float(const int16_t signal[], 
-                                 int32_t length,
-                                 int32_t peak_index)
+static int32_t calculate_circular_prominence(const peak_q_t signal_q16[],
+                                             int32_t length,
+                                             int32_t peak_idx)
+{
+    int32_t peak_value = signal_q16[peak_idx];
+    int32_t left_min = peak_value;
+    int32_t right_min = peak_value;
+    int32_t steps;
+    int32_t i;
+    int32_t ref_level;
+    
+    /* Walk left contour, wrapping from index 0 to length - 1 */
+    i = peak_idx;
+    for (steps = 0; steps < (length - 1); steps++) {
+        i = (i == 0) ? (length - 1) : (i - 1);
+        if (signal_q16[i] >= peak_value) {
+            break;
+        }
+        if (signal_q16[i] < left_min) {
+            left_min = signal_q16[i];
+        }
+    }
+    
+    STATS_ADD(walk_steps_left, steps);
+    
+    /* Walk right contour, wrapping from length - 1 to index 0 */
+    i = peak_idx;
+    for (steps = 0; steps < (length - 1); steps++) {
+        i = (i == (length - 1)) ? 0 : (i + 1);
+        if (signal_q16[i] >= peak_value) {
+            break;
+        }
+        if (signal_q16[i] < right_min) {
+            right_min = signal_q16[i];
+        }
+    }
+    
+    STATS_ADD(walk_steps_right, steps);
+    
+    ref_level = (left_min > right_min) ? left_min : right_min;
+    
+    return q16_sub_sat(peak_value, ref_level);
+}
+
+/*!
+ * @brief Find the most prominent peak in one period of a periodic signal.
+ *
+ * For once-per-revolution frames (encoder angle, rotating machinery):
+ * sample length - 1 is the left neighbour of sample 0. Gradients and
+ * local-maximum tests use wrapped neighbours, so every index including
+ * 0 and length - 1 can be a peak, and contour walks continue across the
+ * frame ends. Each sample is converted and scanned once; no duplicated
+ * frame is needed.
+ *
+ * @param signal Input signal array, exactly one period
+ * @param length Signal length (3 .. MAX_SIGNAL_LENGTH)
+ * @param peak_index Output: index of detected peak
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK if peak found, error code otherwise
+ */
+PeakResultFP find_prominent_peak_fp_circular(const int16_t signal[],
+                                              int32_t length,
+                                              int32_t *peak_index,
+                                              const PeakConfigFP *user_config)
 {
-    int32_t prominence_q16;
+    const PeakConfigFP *config;
+    int32_t count = 0;
+    int32_t grad_prev;
+    int32_t max_prominence = INT32_MIN;
+    int32_t best_idx = -1;
     int32_t i;
     
-    if ((length <= 0) || (length > MAX_SIGNAL_LENGTH) || 
-        (peak_index < 0) || (peak_index >= length)) {
-        return 0.0f;
+    if ((signal == NULL) || (peak_index == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
     }
     
-    /* Convert to Q16.16 */
+    if ((length <= 0) || (length > MAX_SIGNAL_LENGTH)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if (length < 3) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+    
+    config = (user_config != NULL) ? user_config : &default_config_fp;
+    
+    STATS_RESET();
+    STATS_MARK(t_stage);
     for (i = 0; i < length; i++) {
-        s_signal_q16[i] = to_q16(signal[i]);
+        s_signal_q16[i] = (peak_q_t)to_q16(signal[i]);
+    }
+    STATS_ELAPSED(cycles_convert, t_stage);
+    
+    /* Candidate scan over all indices with wrapped neighbours */
+    STATS_MARK(t_candidates);
+    for (i = 0; i < PEAK_BITMAP_WORDS(length); i++) {
+        s_candidates[i] = 0U;
+    }
+    grad_prev = q16_half_diff(s_signal_q16[0], s_signal_q16[length - 2]);  /* At length - 1 */
+    for (i = 0; i < length; i++) {
+        int32_t prev = (i == 0) ? (length - 1) : (i - 1);
+        int32_t next = (i == (length - 1)) ? 0 : (i + 1);
+        int32_t grad_curr = q16_half_diff(s_signal_q16[next], s_signal_q16[prev]);
+        
+        bool is_zero_crossing = (grad_prev > 0) && (grad_curr <= 0);
+        bool is_local_max = (s_signal_q16[i] > s_signal_q16[prev]) &&
+                            (s_signal_q16[i] > s_signal_q16[next]);
+        bool above_noise = (s_signal_q16[i] > config->noise_floor_q16);
+        int32_t grad_mag = (grad_prev > 0) ? grad_prev : -grad_prev;
+        bool strong_gradient = (grad_mag >= config->gradient_threshold_q16);
+        
+        if ((is_zero_crossing || is_local_max) && above_noise && strong_gradient) {
+            s_candidates[i / 32] |= 1U << (i % 32);
+            count++;
+        }
+        
+        grad_prev = grad_curr;
+    }
+    STATS_ELAPSED(cycles_candidates, t_candidates);
+    STATS_ADD(candidates_found, count);
+    
+    if (count == 0) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+    
+    /* Select the most prominent candidate using wrapped walks */
+    STATS_MARK(t_prominence);
+    for (i = 0; i < PEAK_BITMAP_WORDS(length); i++) {
+        uint32_t bits = s_candidates[i];
+        
+        while (bits != 0U) {
+            int32_t idx = (i * 32) + bit_ctz32(bits);
+            int32_t prominence = calculate_circular_prominence(s_signal_q16, length, idx);
+            
+            bits &= bits - 1U;
+            if ((prominence >= config->prominence_threshold_q16) &&
+                (prominence > max_prominence)) {
+                max_prominence = prominence;
+                best_idx = idx;
+            }
+        }
+    }
+    STATS_ELAPSED(cycles_prominence, t_prominence);
+    
+    if (best_idx < 0) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+    
+    *peak_index = best_idx;
+    
+    return PEAK_FP_OK;
+}
+
+/* Position in a region-of-interest mask */
+typedef struct {
+    int32_t position;        /* Next sample not yet handed out */
+    int32_t interval;        /* Next interval to consider */
+} RoiCursor;
+
+/*!
+ * @brief First index in [from, length) whose bitmap bit equals set.
+ *
+ * Whole words without a match are skipped at once.
+ */
+static int32_t roi_bitmap_find(const uint32_t bitmap[], int32_t from, int32_t length, bool set)
+{
+    int32_t i = from;
+    
+    while (i < length) {
+        uint32_t word = set ? bitmap[i / 32] : ~bitmap[i / 32];
+        
+        word >>= (uint32_t)(i % 32);
+        if (word == 0U) {
+            i = ((i / 32) + 1) * 32;
+        } else {
+            while ((word & 1U) == 0U) {
+                word >>= 1;
+                i++;
+            }
+            break;
+        }
+    }
+    
+    return (i < length) ? i : length;
+}
+
+/*!
+ * @brief Next maximal run of scanned samples, [*start, *end).
+ *
+ * @return false when the mask has no further samples
+ */
+static bool roi_next_span(const PeakRoiFP *roi,
+                          int32_t length,
+                          RoiCursor *cursor,
+                          int32_t *start,
+                          int32_t *end)
+{
+    int32_t s = cursor->position;
+    int32_t e;
+    bool include = (roi->mode == PEAK_ROI_INCLUDE);
+    
+    if (roi->bitmap != NULL) {
+        s = roi_bitmap_find(roi->bitmap, s, length, include);
+        e = roi_bitmap_find(roi->bitmap, s, length, !include);
+    } else if (include) {
+        if (cursor->interval >= roi->interval_count) {
+            return false;
+        }
+        s = roi->intervals[cursor->interval].start;
+        e = roi->intervals[cursor->interval].end;
+        cursor->interval++;
+        /* Adjacent intervals form one run */
+        while ((cursor->interval < roi->interval_count) &&
+               (roi->intervals[cursor->interval].start == e)) {
+            e = roi->intervals[cursor->interval].end;
+            cursor->interval++;
+        }
+    } else {
+        /* Gap before the next excluded interval */
+        while ((cursor->interval < roi->interval_count) &&
+               (roi->intervals[cursor->interval].start <= s)) {
+            s = (roi->intervals[cursor->interval].end > s) ?
+                roi->intervals[cursor->interval].end : s;
+            cursor->interval++;
+        }
+        /* Empty intervals exclude nothing */
+        while ((cursor->interval < roi->interval_count) &&
+               (roi->intervals[cursor->interval].start == roi->intervals[cursor->interval].end)) {
+            cursor->interval++;
+        }
+        e = (cursor->interval < roi->interval_count) ?
+            roi->intervals[cursor->interval].start : length;
+    }
+    
+    if (s >= length) {
+        return false;
     }
     
-    prominence_q16 = calculate_topological_prominence(s_signal_q16, length, peak_index);
+    cursor->position = e;
+    *start = s;
+    *end = e;
     
-    return (float)prominence_q16 / (float)Q16_ONE;
+    return true;
+}
+
+/*!
+ * @brief Find the most prominent peak inside a region-of-interest mask.
+ *
+ * Only scanned samples are converted. Each maximal run of them is
+ * searched as if it were passed to find_prominent_peak_fp() on its own
+ * (its own candidates, walks ending at the run edges), so
+ * skipped samples cost nothing and never block or extend a contour.
+ * Ties between runs go to the earlier one. This replaces copying and
+ * blanking samples before a plain call.
+ *
+ * @param signal Input signal array (int16_t ADC samples)
+ * @param length Signal length (must be <= MAX_SIGNAL_LENGTH)
+ * @param roi Mask (intervals sorted, non-overlapping, within [0, length])
+ * @param peak_index Output: index of detected peak in signal
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK if peak found, error code otherwise
+ */
+PeakResultFP find_prominent_peak_fp_roi(const int16_t signal[],
+                                         int32_t length,
+                                         const PeakRoiFP *roi,
+                                         int32_t *peak_index,
+                                         const PeakConfigFP *user_config)
+{
+    const PeakConfigFP *config;
+    RoiCursor cursor = { 0, 0 };
+    int32_t start;
+    int32_t end;
+    int32_t i;
+    int32_t max_prominence = INT32_MIN;
+    int32_t best_idx = -1;
+    
+    if ((signal == NULL) || (roi == NULL) || (peak_index == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if ((length <= 0) || (length > MAX_SIGNAL_LENGTH)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if ((roi->bitmap == NULL) &&
+        ((roi->interval_count < 0) || ((roi->interval_count > 0) && (roi->intervals == NULL)))) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if (roi->bitmap == NULL) {
+        for (i = 0; i < roi->interval_count; i++) {
+            const PeakIntervalFP *iv = &roi->intervals[i];
+            int32_t prev_end = (i > 0) ? roi->intervals[i - 1].end : 0;
+            
+            if ((iv->start < prev_end) || (iv->end < iv->start) || (iv->end > length)) {
+                return PEAK_FP_INVALID_INPUT;
+            }
+        }
+    }
+    
+    config = (user_config != NULL) ? user_config : &default_config_fp;
+    
+    STATS_RESET();
+    
+    while (roi_next_span(roi, length, &cursor, &start, &end)) {
+        int32_t span_length = end - start;
+        int32_t num_candidates;
+        int32_t span_idx;
+        int32_t prominence;
+        
+        if (span_length < 3) {
+            continue;  /* Too short to hold a peak */
+        }
+        
+        STATS_MARK(t_stage);
+        for (i = start; i < end; i++) {
+            s_signal_q16[i] = (peak_q_t)to_q16(signal[i]);
+        }
+        STATS_ELAPSED(cycles_convert, t_stage);
+        
+        STATS_MARK(t_candidates);
+        (void)find_peak_candidates(&s_signal_q16[start], span_length, config,
+                                   s_candidates, &num_candidates);
+        STATS_ELAPSED(cycles_candidates, t_candidates);
+        
+        STATS_MARK(t_prominence);
+        if ((num_candidates > 0) &&
+            (select_prominent_peak(&s_signal_q16[start], span_length, s_candidates,
+                                   config, &span_idx, &prominence) == PEAK_FP_OK) &&
+            (prominence > max_prominence)) {
+            max_prominence = prominence;
+            best_idx = start + span_idx;
+        }
+        STATS_ELAPSED(cycles_prominence, t_prominence);
+    }
+    
+    if (best_idx < 0) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+    
+    *peak_index = best_idx;
+    
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Helper: Get peak prominence (for debugging/validation).
+ *
+ * @param signal Input signal
+ * @param length Signal length
+ * @param peak_index Peak index
+ * @return Prominence as float
+ */
+float get_peak_prominence_float(const int16_t signal[], 
+                                 int32_t length,
+                                 int32_t peak_index)
+{
+    int32_t ref_level;
+    int32_t i;
+    
+    if ((length <= 0) || (length > MAX_SIGNAL_LENGTH) || 
+        (peak_index < 0) || (peak_index >= length)) {
+        return 0.0f;
+    }
+    
+    /* Convert to Q16.16 */
+    for (i = 0; i < length; i++) {
+        s_signal_q16[i] = (peak_q_t)to_q16(signal[i]);
+    }
+    
+    /* Unsaturated: full-scale prominences up to 65535.0 are exact in float */
+    ref_level = topological_ref_level(s_signal_q16, length, peak_index);
+    
+    return (float)((int64_t)s_signal_q16[peak_index] - (int64_t)ref_level) / (float)PEAK_Q_ONE;
+}
+
+/*!
+ * @brief Gradient at a point of a raw int16_t signal (Q16.16 result).
+ *
+ * Same differences as compute_gradient_at(), with samples converted on
+ * access so no working buffer is required.
+ */
+static int32_t compute_gradient_raw(const int16_t signal[],
+                                    int32_t length,
+                                    int32_t index)
+{
+    int32_t grad;
+    
+    if (index == 0) {
+        grad = q16_sub_sat(to_q16(signal[1]), to_q16(signal[0]));
+    } else if (index == (length - 1)) {
+        grad = q16_sub_sat(to_q16(signal[length - 1]), to_q16(signal[length - 2]));
+    } else {
+        grad = q16_half_diff(to_q16(signal[index + 1]), to_q16(signal[index - 1]));
+    }
+    
+    return grad;
+}
+
+/*!
+ * @brief Topological prominence on a raw int16_t signal (Q16.16 result).
+ *
+ * Q16.16 conversion preserves ordering, so the contour walks compare
+ * samples and only the final difference is converted. Samples go through
+ * q_sample() so that Q8.8 clamps them as the conversion does.
+ *
+ * @param signal Signal array
+ * @param length Signal length
+ * @param peak_idx Peak index
+ * @return Prominence in Q16.16 format
+ */
+static int32_t calculate_prominence_raw(const int16_t signal[],
+                                        int32_t length,
+                                        int32_t peak_idx)
+{
+    int16_t peak_value = q_sample(signal[peak_idx]);
+    int16_t left_min = peak_value;
+    int16_t right_min = peak_value;
+    int32_t i;
+    int16_t ref_level;
+    
+    for (i = peak_idx - 1; i >= 0; i--) {
+        int16_t value = q_sample(signal[i]);
+        
+        if (value >= peak_value) {
+            break;
+        }
+        if (value < left_min) {
+            left_min = value;
+        }
+    }
+    
+    STATS_ADD(walk_steps_left, peak_idx - 1 - i);
+    
+    for (i = peak_idx + 1; i < length; i++) {
+        int16_t value = q_sample(signal[i]);
+        
+        if (value >= peak_value) {
+            break;
+        }
+        if (value < right_min) {
+            right_min = value;
+        }
+    }
+    
+    STATS_ADD(walk_steps_right, i - peak_idx - 1);
+    
+    ref_level = (left_min > right_min) ? left_min : right_min;
+    
+    return q16_sub_sat(to_q16(peak_value), to_q16(ref_level));
+}
+
+/*!
+ * @brief Candidate test of peak_iter_next() at index i (1 .. length - 2).
+ */
+static bool is_candidate_raw(const int16_t signal[],
+                             int32_t length,
+                             int32_t i,
+                             const PeakConfigFP *config)
+{
+    int32_t grad_prev = compute_gradient_raw(signal, length, i - 1);
+    int32_t grad_curr = compute_gradient_raw(signal, length, i);
+    
+    bool is_zero_crossing = (grad_prev > 0) && (grad_curr <= 0);
+    int16_t value = q_sample(signal[i]);
+    bool is_local_max = (value > q_sample(signal[i - 1])) &&
+                        (value > q_sample(signal[i + 1]));
+    bool above_noise = (to_q16(value) > config->noise_floor_q16);
+    int32_t grad_mag = (grad_prev > 0) ? grad_prev : -grad_prev;
+    bool strong_gradient = (grad_mag >= config->gradient_threshold_q16);
+    
+    return (is_zero_crossing || is_local_max) && above_noise && strong_gradient;
+}
+
+/*!
+ * @brief Start a lazy scan for peaks.
+ *
+ * No work is done until peak_iter_next() is called; each call advances
+ * the candidate scan only as far as the next peak that passes the
+ * prominence threshold. Consumers that stop early (first N peaks, first
+ * peak matching a predicate) pay only for the prefix they read.
+ *
+ * @param iter Iterator state (caller-owned)
+ * @param signal Input signal array (must stay valid while iterating)
+ * @param length Signal length (no MAX_SIGNAL_LENGTH limit)
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK on success, error code otherwise
+ */
+PeakResultFP peak_iter_init(PeakIteratorFP *iter,
+                            const int16_t signal[],
+                            int32_t length,
+                            const PeakConfigFP *user_config)
+{
+    if ((iter == NULL) || (signal == NULL) || (length <= 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    iter->signal = signal;
+    iter->length = length;
+    iter->config = (user_config != NULL) ? user_config : &default_config_fp;
+    iter->position = length;  /* Exhausted unless set up below */
+    iter->grad_prev = 0;
+    iter->candidates = 0;
+    
+    if (length < 3) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+    
+    iter->position = 1;
+    iter->grad_prev = compute_gradient_raw(signal, length, 0);
+    
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Advance to the next peak above the prominence threshold.
+ *
+ * Peaks are produced in index order using the same candidate rules as
+ * find_peak_candidates().
+ *
+ * @param iter Iterator initialised by peak_iter_init()
+ * @param peak Output: next peak
+ * @return PEAK_FP_OK if a peak was produced, PEAK_FP_NO_PEAK_FOUND when
+ *         the signal is exhausted
+ */
+PeakResultFP peak_iter_next(PeakIteratorFP *iter, PeakInfoFP *peak)
+{
+    const int16_t *signal;
+    const PeakConfigFP *config;
+    int32_t length;
+    int32_t i;
+    int32_t grad_prev;
+    int32_t grad_curr;
+    PeakResultFP result = PEAK_FP_NO_PEAK_FOUND;
+    
+    if ((iter == NULL) || (peak == NULL) || (iter->signal == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    signal = iter->signal;
+    config = iter->config;
+    length = iter->length;
+    grad_prev = iter->grad_prev;
+    
+    for (i = iter->position; i < (length - 1); i++) {
+        int16_t value = q_sample(signal[i]);
+        int32_t value_q16 = to_q16(value);
+        grad_curr = compute_gradient_raw(signal, length, i);
+        
+        bool is_zero_crossing = (grad_prev > 0) && (grad_curr <= 0);
+        bool is_local_max = (value > q_sample(signal[i - 1])) && 
+                            (value > q_sample(signal[i + 1]));
+        bool above_noise = (value_q16 > config->noise_floor_q16);
+        int32_t grad_mag = (grad_prev > 0) ? grad_prev : -grad_prev;
+        bool strong_gradient = (grad_mag >= config->gradient_threshold_q16);
+        
+        grad_prev = grad_curr;
+        
+        if ((is_zero_crossing || is_local_max) && above_noise && strong_gradient) {
+            int32_t prominence = calculate_prominence_raw(signal, length, i);
+            
+            iter->candidates++;
+            
+            if (prominence >= config->prominence_threshold_q16) {
+                peak->index = i;
+                peak->value = value;
+                peak->prominence_q16 = prominence;
+                result = PEAK_FP_OK;
+                i++;
+                break;
+            }
+        }
+    }
+    
+    iter->position = i;
+    iter->grad_prev = grad_prev;
+    
+    return result;
+}
+
+/*!
+ * @brief Most prominent candidate in [first, last) with whole-signal walks.
+ *
+ * @return Index of the best candidate above threshold, -1 if none
+ */
+static int32_t best_candidate_in_range(const int16_t signal[],
+                                       int32_t length,
+                                       int32_t first,
+                                       int32_t last,
+                                       const PeakConfigFP *config,
+                                       int32_t *best_prominence)
+{
+    int32_t i;
+    int32_t best_idx = -1;
+    int32_t max_prominence = INT32_MIN;
+    
+    first = (first < 1) ? 1 : first;
+    last = (last > (length - 1)) ? (length - 1) : last;
+    
+    for (i = first; i < last; i++) {
+        if (is_candidate_raw(signal, length, i, config)) {
+            int32_t prominence = calculate_prominence_raw(signal, length, i);
+            
+            if ((prominence >= config->prominence_threshold_q16) &&
+                (prominence > max_prominence)) {
+                max_prominence = prominence;
+                best_idx = i;
+            }
+        }
+    }
+    
+    *best_prominence = max_prominence;
+    
+    return best_idx;
+}
+
+/*!
+ * @brief One peak per period of a periodic signal.
+ *
+ * The first peak is the most prominent one in the first period. Each
+ * further peak is searched only within +/- period/4 of the position
+ * predicted from the previous one, which acts as an automatic minimum
+ * peak distance of 3/4 period; an empty window (missed beat) moves the
+ * prediction on by one period. Candidate tests and prominence walks are
+ * done only inside the windows, while the walks themselves see the
+ * whole signal, so prominences equal those of peak_iter_next(). Use
+ * peak_period_estimate() (autocorr-period.h) to obtain the period.
+ *
+ * @param signal Input signal array (int16_t ADC samples)
+ * @param length Signal length (not limited by MAX_SIGNAL_LENGTH)
+ * @param period Signal period in samples (>= 2; larger than length searches
+ *        the whole signal once)
+ * @param peaks Output: peaks in index order
+ * @param max_peaks Capacity of peaks
+ * @param num_peaks Output: peaks written
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK if at least one peak was found, PEAK_FP_NO_PEAK_FOUND
+ *         if none, PEAK_FP_BUFFER_TOO_SMALL if peaks filled up first
+ */
+PeakResultFP find_periodic_peaks_fp(const int16_t signal[],
+                                    int32_t length,
+                                    int32_t period,
+                                    PeakInfoFP peaks[],
+                                    int32_t max_peaks,
+                                    int32_t *num_peaks,
+                                    const PeakConfigFP *user_config)
+{
+    const PeakConfigFP *config;
+    int64_t tolerance;
+    int64_t first;    /* Window positions in int64: period may be near INT32_MAX */
+    int64_t last;
+    int32_t count = 0;
+    
+    if ((signal == NULL) || (peaks == NULL) || (num_peaks == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if ((length <= 0) || (period < 2) || (max_peaks < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    *num_peaks = 0;
+    
+    if (length < 3) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+    
+    config = (user_config != NULL) ? user_config : &default_config_fp;
+    tolerance = period / 4;
+    
+    /* First peak: anywhere in the first period */
+    first = 1;
+    last = period;
+    
+    while (first < (length - 1)) {
+        int32_t prominence;
+        int32_t idx = best_candidate_in_range(signal, length, (int32_t)first,
+                                              (int32_t)((last < length) ? last : length),
+                                              config, &prominence);
+        int64_t predicted;
+        
+        if (idx >= 0) {
+            if (count >= max_peaks) {
+                *num_peaks = count;
+                return PEAK_FP_BUFFER_TOO_SMALL;
+            }
+            peaks[count].index = idx;
+            peaks[count].value = q_sample(signal[idx]);
+            peaks[count].prominence_q16 = prominence;
+            count++;
+            predicted = (int64_t)idx + period;
+        } else if (count == 0) {
+            /* Nothing in this period yet: try the next whole period */
+            first = last;
+            last = first + period;
+            continue;
+        } else {
+            predicted = (first + tolerance) + period;  /* Missed peak */
+        }
+        
+        first = predicted - tolerance;
+        last = predicted + tolerance + 1;
+    }
+    
+    *num_peaks = count;
+    
+    return (count > 0) ? PEAK_FP_OK : PEAK_FP_NO_PEAK_FOUND;
+}
+
+/*!
+ * @brief Fused preprocessing and detection: smooth -> detrend -> peaks.
+ *
+ * All stages run in a single pass over the input. Each sample is
+ * smoothed (centred moving average, running sum), detrended (EMA
+ * baseline subtraction) and written once to the working buffer, while
+ * the candidate scan trails one sample behind on values still held in
+ * registers. Only the prominence walks revisit the buffer.
+ *
+ * With both stages disabled the result is identical to
+ * find_prominent_peak_fp(). Thresholds in the configuration apply to the
+ * preprocessed signal.
+ *
+ * @param signal Input signal array (int16_t ADC samples)
+ * @param length Signal length (must be <= MAX_SIGNAL_LENGTH)
+ * @param pipeline Stage settings (NULL disables all stages)
+ * @param peak_index Output: index of detected peak
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK if peak found, error code otherwise
+ */
+PeakResultFP find_prominent_peak_pipeline_fp(const int16_t signal[],
+                                              int32_t length,
+                                              const PeakPipelineFP *pipeline,
+                                              int32_t *peak_index,
+                                              const PeakConfigFP *user_config)
+{
+    const PeakConfigFP *config;
+    int32_t half_width = 0;
+    int32_t detrend_shift = 0;
+    int32_t window_sum = 0;
+    int64_t baseline = 0;    /* Detrend baseline << PIPE_BASELINE_EXTRA */
+    int32_t y_prev2 = 0;     /* Stage output at j - 2 */
+    int32_t y_prev1 = 0;     /* Stage output at j - 1 */
+    int32_t grad_prev = 0;   /* Gradient at j - 2 */
+    int32_t count = 0;
+    int32_t j;
+    PeakResultFP result;
+    
+    if ((signal == NULL) || (peak_index == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if ((length <= 0) || (length > MAX_SIGNAL_LENGTH)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if (pipeline != NULL) {
+        half_width = pipeline->smooth_half_width;
+        detrend_shift = pipeline->detrend_shift;
+    }
+    
+    if ((half_width < 0) || (half_width >= length) ||
+        (detrend_shift < 0) || (detrend_shift > 15)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if (length < 3) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+    
+    config = (user_config != NULL) ? user_config : &default_config_fp;
+    
+    STATS_RESET();
+    STATS_MARK(t_fused);
+    for (j = 0; j < PEAK_BITMAP_WORDS(length); j++) {
+        s_candidates[j] = 0U;
+    }
+    
+    /* Prime the running sum with the right half of the first window */
+    for (j = 0; j < half_width; j++) {
+        window_sum += q_sample(signal[j]);
+    }
+    
+    for (j = 0; j < length; j++) {
+        int32_t y;
+        
+        /* Stage 1: centred moving average, window truncated at the edges */
+        if (half_width > 0) {
+            int32_t lo = (j > half_width) ? (j - half_width) : 0;
+            int32_t hi = ((j + half_width) < length) ? (j + half_width) : (length - 1);
+            
+            if ((j + half_width) < length) {
+                window_sum += q_sample(signal[j + half_width]);
+            }
+            if ((j - half_width - 1) >= 0) {
+                window_sum -= q_sample(signal[j - half_width - 1]);
+            }
+            y = (int32_t)(((int64_t)window_sum * PEAK_Q_SAMPLE_ONE) / (int64_t)(hi - lo + 1));
+        } else {
+            y = to_q16(signal[j]);
+        }
+        
+        /* Stage 2: remove slowly varying baseline */
+        if (detrend_shift > 0) {
+            int64_t y_wide = (int64_t)y * ((int64_t)1 << PIPE_BASELINE_EXTRA);
+            
+            if (j == 0) {
+                baseline = y_wide;
+            } else {
+                baseline += (y_wide - baseline) >> detrend_shift;
+            }
+            y = q16_sub_sat(y, (int32_t)(baseline >> PIPE_BASELINE_EXTRA));
+        }
+        
+        y = q_narrow(y);
+        s_signal_q16[j] = (peak_q_t)y;
+        
+        /* Stage 3: candidate test for i = j - 1, now that i + 1 is known */
+        if (j == 1) {
+            grad_prev = q16_sub_sat(y, y_prev1);  /* Forward difference at index 0 */
+        } else if (j >= 2) {
+            int32_t grad_curr = q16_half_diff(y, y_prev2);
+            bool is_zero_crossing = (grad_prev > 0) && (grad_curr <= 0);
+            bool is_local_max = (y_prev1 > y_prev2) && (y_prev1 > y);
+            bool above_noise = (y_prev1 > config->noise_floor_q16);
+            int32_t grad_mag = (grad_prev > 0) ? grad_prev : -grad_prev;
+            bool strong_gradient = (grad_mag >= config->gradient_threshold_q16);
+            
+            if ((is_zero_crossing || is_local_max) && above_noise && strong_gradient) {
+                s_candidates[(j - 1) / 32] |= 1U << ((j - 1) % 32);
+                count++;
+            }
+            
+            grad_prev = grad_curr;
+        } else {
+            /* j == 0: nothing to test yet */
+        }
+        
+        y_prev2 = y_prev1;
+        y_prev1 = y;
+    }
+    
+    /* Conversion, filtering and candidate scan are one fused loop */
+    STATS_ELAPSED(cycles_candidates, t_fused);
+    STATS_ADD(candidates_found, count);
+    
+    if (count == 0) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+    
+    STATS_MARK(t_prominence);
+    result = select_prominent_peak(s_signal_q16, length, s_candidates,
+                                   config, peak_index, NULL);
+    STATS_ELAPSED(cycles_prominence, t_prominence);
+    
+    return result;
+}
+
+/*!
+ * @brief Initialise a resumable streaming detector.
+ *
+ * The stream splits incoming samples into consecutive frames of
+ * frame_length and yields the peaks of each completed frame. All state
+ * lives in the caller's PeakStreamFP and frame buffer; nothing is
+ * allocated, so any number of streams can be multiplexed on one thread.
+ *
+ * @param stream Stream state (caller-owned)
+ * @param frame_buffer Caller-provided storage of frame_length samples
+ * @param frame_length Samples per frame (>= 3)
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK on success, error code otherwise
+ */
+PeakResultFP peak_stream_init(PeakStreamFP *stream,
+                              int16_t frame_buffer[],
+                              int32_t frame_length,
+                              const PeakConfigFP *user_config)
+{
+    if ((stream == NULL) || (frame_buffer == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if (frame_length < 3) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+    
+    stream->frame = frame_buffer;
+    stream->frame_length = frame_length;
+    stream->fill = 0;
+    stream->pending = NULL;
+    stream->pending_count = 0;
+    stream->frame_start = 0U;
+    stream->frame_ready = false;
+    stream->in_place = false;
+    stream->config = (user_config != NULL) ? user_config : &default_config_fp;
+    
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Hand the next block of samples to the stream.
+ *
+ * The block is consumed lazily by peak_stream_next() and must stay
+ * valid until that call reports PEAK_FP_NO_PEAK_FOUND (input drained).
+ * Whole frames that lie inside the block are scanned in place; only
+ * frames straddling two blocks are copied into the frame buffer.
+ *
+ * @param stream Stream state
+ * @param block Sample block
+ * @param count Number of samples in block
+ * @return PEAK_FP_OK, or PEAK_FP_INVALID_INPUT if the previous block
+ *         has not been drained yet
+ */
+PeakResultFP peak_stream_feed(PeakStreamFP *stream,
+                              const int16_t block[],
+                              int32_t count)
+{
+    if ((stream == NULL) || (block == NULL) || (count < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if (stream->pending_count > 0) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    stream->pending = block;
+    stream->pending_count = count;
+    
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Resume the stream and yield the next finalised peak.
+ *
+ * Peaks are reported with stream-relative indices (samples since
+ * peak_stream_init(), modulo 2^31; see PEAK_STREAM_INDEX_MASK). When the fed input is exhausted the call returns
+ * PEAK_FP_NO_PEAK_FOUND; feed another block and resume.
+ *
+ * @param stream Stream state
+ * @param peak Output: next peak
+ * @return PEAK_FP_OK if a peak was produced, PEAK_FP_NO_PEAK_FOUND when
+ *         more input is needed
+ */
+PeakResultFP peak_stream_next(PeakStreamFP *stream, PeakInfoFP *peak)
+{
+    int32_t i;
+    
+    if ((stream == NULL) || (peak == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    for (;;) {
+        if (stream->frame_ready) {
+            if (peak_iter_next(&stream->iter, peak) == PEAK_FP_OK) {
+                peak->index = (int32_t)(((uint32_t)peak->index + stream->frame_start) &
+                                        PEAK_STREAM_INDEX_MASK);
+                return PEAK_FP_OK;
+            }
+            
+            /* Frame drained: start collecting the next one */
+            if (stream->in_place) {
+                stream->pending += stream->frame_length;
+                stream->pending_count -= stream->frame_length;
+                stream->in_place = false;
+            }
+            stream->frame_ready = false;
+            stream->frame_start += (uint32_t)stream->frame_length;
+            stream->fill = 0;
+        }
+        
+        if (stream->pending_count == 0) {
+            return PEAK_FP_NO_PEAK_FOUND;
+        }
+        
+        /* Whole frame available in the block: scan it where it lies */
+        if ((stream->fill == 0) && (stream->pending_count >= stream->frame_length)) {
+            (void)peak_iter_init(&stream->iter, stream->pending,
+                                 stream->frame_length, stream->config);
+            stream->in_place = true;
+            stream->frame_ready = true;
+            continue;
+        }
+        
+        /* Copy as much of the pending block as fits in the frame */
+        for (i = 0; (i < stream->pending_count) &&
+                    (stream->fill < stream->frame_length); i++) {
+            stream->frame[stream->fill] = stream->pending[i];
+            stream->fill++;
+        }
+        stream->pending += i;
+        stream->pending_count -= i;
+        
+        if (stream->fill == stream->frame_length) {
+            (void)peak_iter_init(&stream->iter, stream->frame,
+                                 stream->frame_length, stream->config);
+            stream->frame_ready = true;
+        }
+    }
+}
+
+/*!
+ * @brief Initialise a monotonic arena over caller-provided memory.
+ *
+ * @param arena Arena state
+ * @param memory Backing storage
+ * @param capacity Size of memory in bytes
+ */
+void peak_arena_init(PeakArenaFP *arena, void *memory, size_t capacity)
+{
+    if (arena == NULL) {
+        return;
+    }
+    
+    arena->base = (uint8_t *)memory;
+    arena->capacity = (memory != NULL) ? capacity : 0U;
+    arena->used = 0U;
+}
+
+/*!
+ * @brief Release everything allocated from the arena (O(1)).
+ */
+void peak_arena_reset(PeakArenaFP *arena)
+{
+    if (arena != NULL) {
+        arena->used = 0U;
+    }
+}
+
+/*!
+ * @brief Bump-allocate from the arena.
+ *
+ * @param arena Arena state
+ * @param size Bytes requested
+ * @return Pointer aligned to PEAK_ARENA_ALIGN, or NULL if exhausted
+ */
+void *peak_arena_alloc(PeakArenaFP *arena, size_t size)
+{
+    size_t offset;
+    
+    if ((arena == NULL) || (arena->base == NULL)) {
+        return NULL;
+    }
+    
+    offset = (arena->used + (PEAK_ARENA_ALIGN - 1U)) & ~(size_t)(PEAK_ARENA_ALIGN - 1U);
+    
+    if ((offset > arena->capacity) || (size > (arena->capacity - offset))) {
+        return NULL;
+    }
+    
+    arena->used = offset + size;
+    
+    return &arena->base[offset];
+}
+
+/*!
+ * @brief Find all peaks above the prominence threshold into an arena.
+ *
+ * The result array is carved from the arena's free tail and grown in
+ * place while scanning, then trimmed to the number of peaks found, so
+ * the arena holds exactly count * sizeof(PeakInfoFP) bytes for the call
+ * and no per-frame heap traffic occurs. Reset the arena between frames.
+ *
+ * @param signal Input signal array
+ * @param length Signal length (no MAX_SIGNAL_LENGTH limit)
+ * @param user_config Optional configuration (NULL for default)
+ * @param arena Arena supplying the result storage
+ * @param list Output: peaks in index order
+ * @return PEAK_FP_OK if at least one peak was found,
+ *         PEAK_FP_BUFFER_TOO_SMALL if the arena filled up (list holds
+ *         the peaks that fit), error code otherwise
+ */
+PeakResultFP find_peaks_arena_fp(const int16_t signal[],
+                                 int32_t length,
+                                 const PeakConfigFP *user_config,
+                                 PeakArenaFP *arena,
+                                 PeakListFP *list)
+{
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    PeakInfoFP *peaks;
+    size_t offset;
+    size_t capacity;
+    int32_t count = 0;
+    PeakResultFP result;
+    
+    if ((arena == NULL) || (list == NULL) || (arena->base == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    list->peaks = NULL;
+    list->count = 0;
+    
+    result = peak_iter_init(&iter, signal, length, user_config);
+    if (result != PEAK_FP_OK) {
+        return result;
+    }
+    
+    /* Reserve the whole free tail; trimmed once the count is known */
+    offset = (arena->used + (PEAK_ARENA_ALIGN - 1U)) & ~(size_t)(PEAK_ARENA_ALIGN - 1U);
+    capacity = (offset < arena->capacity) ?
+               ((arena->capacity - offset) / sizeof(PeakInfoFP)) : 0U;
+    peaks = (PeakInfoFP *)(void *)&arena->base[offset];
+    
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        if ((size_t)count >= capacity) {
+            result = PEAK_FP_BUFFER_TOO_SMALL;
+            break;
+        }
+        peaks[count] = peak;
+        count++;
+    }
+    
+    if (count > 0) {
+        arena->used = offset + ((size_t)count * sizeof(PeakInfoFP));
+        list->peaks = peaks;
+        list->count = count;
+    } else if (result == PEAK_FP_OK) {
+        result = PEAK_FP_NO_PEAK_FOUND;
+    } else {
+        /* Arena full before the first peak */
+    }
+    
+    return result;
+}
+
+/*!
+ * @brief Samples from a stack entry to the current position.
+ *
+ * Entries keep the low bits of their position (16 in narrow builds).
+ * An entry that has not expired is at most horizon samples old, so its
+ * age is exact, also across a wrap of the position counter.
+ */
+static inline int32_t pingpong_age(const PeakPingPongFP *pp, const PeakStackEntryFP *entry)
+{
+    return (int32_t)(peak_stream_pos_t)(pp->position - (uint32_t)entry->index);
+}
+
+/*!
+ * @brief Stack entry k (0 = sentinel) of the ring starting at pp->bottom.
+ */
+static inline PeakStackEntryFP *pingpong_entry(const PeakPingPongFP *pp, int32_t k)
+{
+    int32_t slot = pp->bottom + k;
+    
+    return &pp->stack[(slot >= pp->capacity) ? (slot - pp->capacity) : slot];
+}
+
+/*!
+ * @brief Emit a finalised ping-pong candidate if it is prominent enough.
+ */
+static void pingpong_report(PeakPingPongFP *pp,
+                            PeakStackEntryFP *entry,
+                            int32_t right_min)
+{
+    int32_t ref_level = (entry->left_min_q16 > right_min) ? entry->left_min_q16 : right_min;
+    int32_t prominence = q16_sub_sat(entry->value_q16, ref_level);
+    
+    entry->flags |= PEAK_PP_REPORTED;
+    
+    if (prominence < pp->config->prominence_threshold_q16) {
+        return;
+    }
+    
+    if (pp->out_count < pp->out_capacity) {
+        pp->out[pp->out_count].index = (int32_t)((pp->position - (uint32_t)pingpong_age(pp, entry)) &
+                                                 PEAK_STREAM_INDEX_MASK);
+        pp->out[pp->out_count].value = from_q16(entry->value_q16);
+        pp->out[pp->out_count].prominence_q16 = prominence;
+        pp->out_count++;
+    } else {
+        pp->out_overflow = true;
+    }
+}
+
+/*!
+ * @brief Finalise stack entry pos with its right walk cut at the newest sample.
+ */
+static void pingpong_truncate(PeakPingPongFP *pp, int32_t pos)
+{
+    PeakStackEntryFP *entry = pingpong_entry(pp, pos);
+    int32_t right_min = entry->value_q16;
+    int32_t k;
+    
+    if ((entry->flags & (PEAK_PP_CANDIDATE | PEAK_PP_REPORTED)) != PEAK_PP_CANDIDATE) {
+        return;
+    }
+    
+    /* Everything after the entry lies in the entries above it */
+    for (k = pos; k < pp->depth; k++) {
+        const PeakStackEntryFP *e = pingpong_entry(pp, k);
+        if ((k > pos) && (e->value_q16 < right_min)) {
+            right_min = e->value_q16;
+        }
+        if (e->run_min_q16 < right_min) {
+            right_min = e->run_min_q16;
+        }
+    }
+    
+    pingpong_report(pp, entry, right_min);
+}
+
+/*!
+ * @brief Push one sample through the monotonic stack.
+ */
+static void pingpong_push(PeakPingPongFP *pp, int32_t x)
+{
+    PeakStackEntryFP *below;
+    PeakStackEntryFP *entry;
+    int32_t gap = INT32_MAX;        /* Minimum of samples above the current top */
+    int32_t equal_gap = INT32_MAX;  /* Samples between an equal entry and x */
+    bool stopped_by_equal = false;
+    int32_t left_min;
+    int32_t lo;
+    int32_t hi;
+    
+    /* Samples no higher than x end their right walk at x */
+    while ((pp->depth > 1) && (pingpong_entry(pp, pp->depth - 1)->value_q16 <= x)) {
+        PeakStackEntryFP *top = pingpong_entry(pp, pp->depth - 1);
+        int32_t after = (top->run_min_q16 < gap) ? top->run_min_q16 : gap;
+        
+        if ((top->flags & (PEAK_PP_CANDIDATE | PEAK_PP_REPORTED)) == PEAK_PP_CANDIDATE) {
+            pingpong_report(pp, top, (after < top->value_q16) ? after : top->value_q16);
+        }
+        
+        pp->depth--;
+        gap = (after < top->value_q16) ? after : top->value_q16;
+        
+        if (top->value_q16 == x) {
+            /* An equal sample also stops the left walk of x */
+            equal_gap = after;
+            stopped_by_equal = true;
+            break;
+        }
+    }
+    
+    /* Everything popped lies between the new top and x */
+    below = pingpong_entry(pp, pp->depth - 1);
+    if (gap < below->run_min_q16) {
+        below->run_min_q16 = gap;
+    }
+    
+    if (stopped_by_equal) {
+        left_min = (equal_gap < x) ? equal_gap : x;
+    } else {
+        left_min = (below->run_min_q16 < x) ? below->run_min_q16 : x;
+    }
+    
+    /* Full stack: the oldest entry becomes the left boundary. It turns
+     * into the sentinel and the ring moves up one slot, so dropping it
+     * is O(1) however long the falling stretch. */
+    if (pp->depth == pp->capacity) {
+        PeakStackEntryFP *oldest = pingpong_entry(pp, 1);
+        
+        pingpong_truncate(pp, 1);
+        oldest->run_min_q16 = (oldest->run_min_q16 < oldest->value_q16) ?
+                              oldest->run_min_q16 : oldest->value_q16;
+        oldest->value_q16 = INT32_MAX;
+        oldest->left_min_q16 = INT32_MAX;
+        oldest->flags = 0U;
+        pp->bottom = ((pp->bottom + 1) == pp->capacity) ? 0 : (pp->bottom + 1);
+        pp->depth--;
+    }
+    
+    entry = pingpong_entry(pp, pp->depth);
+    entry->index = (peak_stream_pos_t)pp->position;
+    entry->value_q16 = x;
+    entry->left_min_q16 = left_min;
+    entry->run_min_q16 = INT32_MAX;
+    entry->flags = 0U;
+    pp->depth++;
+    
+    /* Latency bound: finalise the candidate horizon samples back.
+     * Expired entries form the bottom of the stack and are skipped. */
+    lo = 1;
+    hi = pp->depth - 1;
+    while (lo <= hi) {
+        int32_t mid = lo + ((hi - lo) / 2);
+        PeakStackEntryFP *probe = pingpong_entry(pp, mid);
+        int32_t age = ((probe->flags & PEAK_PP_EXPIRED) != 0U) ?
+                      INT32_MAX : pingpong_age(pp, probe);
+        
+        if (age > pp->horizon) {
+            lo = mid + 1;
+        } else if (age == pp->horizon) {
+            pingpong_truncate(pp, mid);
+            probe->flags |= PEAK_PP_EXPIRED;
+            break;
+        } else {
+            hi = mid - 1;
+        }
+    }
+}
+
+/*!
+ * @brief Initialise a ping-pong (continuous stream) detector.
+ *
+ * Peaks follow the frame detector's candidate rules and prominence,
+ * evaluated on the unbroken stream: a peak on the boundary between two
+ * DMA halves is seen with both of its sides and reported exactly once.
+ * A candidate is reported no later than horizon samples after it occurs;
+ * its right walk is cut there if still open. Left walks reach back to the
+ * oldest sample held by the stack (stack_capacity - 1 entries, only
+ * exhausted by long monotonically falling stretches).
+ *
+ * @param pp Detector state (caller-owned)
+ * @param stack Caller-provided stack storage
+ * @param stack_capacity Entries in stack (> horizon + 1)
+ * @param horizon Latency bound in samples (1 .. PEAK_INDEX_MAX), e.g. the
+ *        half-buffer size
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK on success, error code otherwise
+ */
+PeakResultFP peak_pingpong_init(PeakPingPongFP *pp,
+                                PeakStackEntryFP stack[],
+                                int32_t stack_capacity,
+                                int32_t horizon,
+                                const PeakConfigFP *user_config)
+{
+    if ((pp == NULL) || (stack == NULL) || (horizon < 1) || (horizon > PEAK_INDEX_MAX)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if ((stack_capacity - 1) <= horizon) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+    
+    pp->stack = stack;
+    pp->capacity = stack_capacity;
+    pp->bottom = 0;
+    pp->depth = 1;
+    pp->horizon = horizon;
+    pp->position = 0U;
+    pp->primed = 0;
+    pp->x_prev1_q16 = 0;
+    pp->x_prev2_q16 = 0;
+    pp->grad_prev = 0;
+    pp->out = NULL;
+    pp->out_capacity = 0;
+    pp->out_count = 0;
+    pp->out_overflow = false;
+    pp->config = (user_config != NULL) ? user_config : &default_config_fp;
+    
+    /* Sentinel: higher than any sample, never popped */
+    stack[0].index = 0U;
+    stack[0].value_q16 = INT32_MAX;
+    stack[0].left_min_q16 = INT32_MAX;
+    stack[0].run_min_q16 = INT32_MAX;
+    stack[0].flags = 0U;
+    
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Process one DMA half (call from the half/full-transfer callback).
+ *
+ * Peaks are written in the order they are finalised, with stream-relative
+ * indices (modulo 2^31, see PEAK_STREAM_INDEX_MASK); state carries over
+ * to the next half. The detector can run indefinitely.
+ *
+ * @param pp Detector state
+ * @param half Samples of the half just completed
+ * @param count Samples in half
+ * @param peaks Output array
+ * @param max_peaks Capacity of peaks
+ * @param num_peaks Output: peaks written
+ * @return PEAK_FP_OK, or PEAK_FP_BUFFER_TOO_SMALL if peaks overflowed
+ *         (processing still completes; extra peaks are lost)
+ */
+PeakResultFP peak_pingpong_process(PeakPingPongFP *pp,
+                                   const int16_t half[],
+                                   int32_t count,
+                                   PeakInfoFP peaks[],
+                                   int32_t max_peaks,
+                                   int32_t *num_peaks)
+{
+    const PeakConfigFP *config;
+    int32_t i;
+    
+    if ((pp == NULL) || (half == NULL) || (peaks == NULL) ||
+        (num_peaks == NULL) || (count < 0) || (max_peaks < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    config = pp->config;
+    pp->out = peaks;
+    pp->out_capacity = max_peaks;
+    pp->out_count = 0;
+    pp->out_overflow = false;
+    
+    for (i = 0; i < count; i++) {
+        int32_t x = to_q16(half[i]);
+        
+        if (pp->primed == 1) {
+            pp->grad_prev = q16_sub_sat(x, pp->x_prev1_q16);  /* Forward difference at 0 */
+        } else if (pp->primed == 2) {
+            /* Candidate test for the previous sample (the current top) */
+            int32_t y = pp->x_prev1_q16;
+            int32_t grad_curr = q16_half_diff(x, pp->x_prev2_q16);
+            bool is_zero_crossing = (pp->grad_prev > 0) && (grad_curr <= 0);
+            bool is_local_max = (y > pp->x_prev2_q16) && (y > x);
+            bool above_noise = (y > config->noise_floor_q16);
+            int32_t grad_mag = (pp->grad_prev > 0) ? pp->grad_prev : -pp->grad_prev;
+            bool strong_gradient = (grad_mag >= config->gradient_threshold_q16);
+            
+            if ((is_zero_crossing || is_local_max) && above_noise && strong_gradient) {
+                pingpong_entry(pp, pp->depth - 1)->flags |= PEAK_PP_CANDIDATE;
+            }
+            
+            pp->grad_prev = grad_curr;
+        } else {
+            /* First sample */
+        }
+        
+        pingpong_push(pp, x);
+        
+        pp->x_prev2_q16 = pp->x_prev1_q16;
+        pp->x_prev1_q16 = x;
+        pp->position++;
+        pp->primed = (pp->primed < 2) ? (pp->primed + 1) : 2;
+    }
+    
+    *num_peaks = pp->out_count;
+    pp->out = NULL;
+    
+    return pp->out_overflow ? PEAK_FP_BUFFER_TOO_SMALL : PEAK_FP_OK;
+}
+
+/*!
+ * @brief End of stream: finalise every pending candidate.
+ *
+ * Open right walks end at the last sample, as at the end of a frame.
+ *
+ * @param pp Detector state
+ * @param peaks Output array
+ * @param max_peaks Capacity of peaks
+ * @param num_peaks Output: peaks written
+ * @return PEAK_FP_OK, or PEAK_FP_BUFFER_TOO_SMALL if peaks overflowed
+ */
+PeakResultFP peak_pingpong_flush(PeakPingPongFP *pp,
+                                 PeakInfoFP peaks[],
+                                 int32_t max_peaks,
+                                 int32_t *num_peaks)
+{
+    int32_t pos;
+    
+    if ((pp == NULL) || (peaks == NULL) || (num_peaks == NULL) || (max_peaks < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    pp->out = peaks;
+    pp->out_capacity = max_peaks;
+    pp->out_count = 0;
+    pp->out_overflow = false;
+    
+    for (pos = 1; pos < pp->depth; pos++) {
+        pingpong_truncate(pp, pos);
+    }
+    
+    *num_peaks = pp->out_count;
+    pp->out = NULL;
+    
+    return pp->out_overflow ? PEAK_FP_BUFFER_TOO_SMALL : PEAK_FP_OK;
+}
+
+/*!
+ * @brief Sample at local index a of the current sliding window.
+ */
+static inline int32_t slide_at(const PeakSlideFP *slide, int32_t a)
+{
+    /* Double mapping keeps [start, start + window) contiguous */
+    return slide->samples_q16[(slide->start % slide->window) + (a - slide->start)];
+}
+
+/*!
+ * @brief Local index of a live candidate.
+ *
+ * Live candidates lie in [start - hop, start + window), so narrow builds
+ * recover the index from its low 16 bits.
+ */
+static inline int32_t slide_index(const PeakSlideFP *slide, const PeakSlideCandidateFP *cand)
+{
+#ifdef PEAK_FP_NARROW_INDEX
+    int32_t base = slide->start - slide->hop;
+    
+    return base + (int32_t)(uint16_t)((uint32_t)cand->index - (uint32_t)base);
+#else
+    (void)slide;
+    return (int32_t)cand->index;
+#endif
+}
+
+/*!
+ * @brief Move a multiple of window from the local counters into origin.
+ *
+ * Ring positions (index % window and the hop block) do not change, so
+ * only start, received and the candidate indices shift. Called between
+ * hops, when every live candidate lies above start.
+ */
+static void slide_rebase(PeakSlideFP *slide)
+{
+    int32_t shift = slide->start - (slide->start % slide->window);
+    int32_t k;
+    
+    slide->start -= shift;
+    slide->received -= shift;
+    slide->origin += (uint32_t)shift;
+    for (k = 0; k < slide->cand_count; k++) {
+        PeakSlideCandidateFP *cand = &slide->cands[(slide->cand_head + k) % slide->cand_capacity];
+        
+        cand->index = (peak_stream_pos_t)((uint32_t)cand->index - (uint32_t)shift);
+    }
+}
+
+/*!
+ * @brief Append hop samples and record their block extremes.
+ */
+static void slide_append(PeakSlideFP *slide, const int16_t samples[], int32_t first)
+{
+    int32_t block_min = INT32_MAX;
+    int32_t block_max = INT32_MIN;
+    int32_t k;
+    
+    for (k = 0; k < slide->hop; k++) {
+        int32_t q = to_q16(samples[k]);
+        int32_t pos = (first + k) % slide->window;
+        
+        slide->samples_q16[pos] = (peak_q_t)q;
+        slide->samples_q16[pos + slide->window] = (peak_q_t)q;
+        block_min = (q < block_min) ? q : block_min;
+        block_max = (q > block_max) ? q : block_max;
+    }
+    
+    k = (first / slide->hop) % (slide->window / slide->hop);
+    slide->blocks[k].min_q16 = block_min;
+    slide->blocks[k].max_q16 = block_max;
+}
+
+/*!
+ * @brief Left contour walk from index i down to the window start.
+ *
+ * Whole hop blocks lower than the peak are crossed in one step using
+ * their cached minimum.
+ */
+static void slide_walk_left(const PeakSlideFP *slide, PeakSlideCandidateFP *cand)
+{
+    int32_t index = slide_index(slide, cand);
+    int32_t value = slide_at(slide, index);
+    int32_t min_q16 = value;
+    int32_t nblocks = slide->window / slide->hop;
+    int32_t a = index - 1;
+    
+    while (a >= slide->start) {
+        const PeakSlideBlockFP *block = &slide->blocks[(a / slide->hop) % nblocks];
+        int32_t sample;
+        
+        STATS_ADD(walk_steps_left, 1);
+        if ((((a + 1) % slide->hop) == 0) && (block->max_q16 < value)) {
+            min_q16 = (block->min_q16 < min_q16) ? block->min_q16 : min_q16;
+            a -= slide->hop;
+        } else {
+            sample = slide_at(slide, a);
+            if (sample >= value) {
+                break;
+            }
+            min_q16 = (sample < min_q16) ? sample : min_q16;
+            a--;
+        }
+    }
+    
+    cand->left_span = (peak_index_t)(index - a);
+    cand->left_min_q16 = min_q16;
+}
+
+/*!
+ * @brief Right contour walk from index i up to the window end.
+ *
+ * @return true if the walk stopped at a sample >= the peak
+ */
+static bool slide_walk_right(const PeakSlideFP *slide, PeakSlideCandidateFP *cand)
+{
+    int32_t index = slide_index(slide, cand);
+    int32_t value = slide_at(slide, index);
+    int32_t min_q16 = value;
+    int32_t end = slide->start + slide->window;
+    int32_t nblocks = slide->window / slide->hop;
+    int32_t a = index + 1;
+    bool stopped = false;
+    
+    while (a < end) {
+        const PeakSlideBlockFP *block = &slide->blocks[(a / slide->hop) % nblocks];
+        int32_t sample;
+        
+        STATS_ADD(walk_steps_right, 1);
+        if (((a % slide->hop) == 0) && (block->max_q16 < value)) {
+            min_q16 = (block->min_q16 < min_q16) ? block->min_q16 : min_q16;
+            a += slide->hop;
+        } else {
+            sample = slide_at(slide, a);
+            if (sample >= value) {
+                stopped = true;
+                break;
+            }
+            min_q16 = (sample < min_q16) ? sample : min_q16;
+            a++;
+        }
+    }
+    
+    cand->right_min_q16 = min_q16;
+    
+    return stopped;
+}
+
+/*!
+ * @brief Heap order: higher prominence first, then lower index (the
+ *        tie rule of select_prominent_peak()).
+ */
+static bool slide_ranks_above(const PeakSlideFP *slide, int32_t slot_a, int32_t slot_b)
+{
+    const PeakSlideCandidateFP *a = &slide->cands[slot_a];
+    const PeakSlideCandidateFP *b = &slide->cands[slot_b];
+    
+    if (a->prominence_q16 != b->prominence_q16) {
+        return a->prominence_q16 > b->prominence_q16;
+    }
+    
+    return slide_index(slide, a) < slide_index(slide, b);
+}
+
+/*!
+ * @brief Store candidate slot at heap position pos.
+ */
+static inline void slide_heap_place(PeakSlideFP *slide, int32_t pos, int32_t slot)
+{
+    slide->cands[pos].heap_slot = (peak_index_t)slot;
+    slide->cands[slot].heap_pos = (peak_index_t)pos;
+}
+
+/*!
+ * @brief Restore the heap order around position pos.
+ */
+static void slide_heap_fix(PeakSlideFP *slide, int32_t pos)
+{
+    int32_t slot = (int32_t)slide->cands[pos].heap_slot;
+    
+    while (pos > 0) {
+        int32_t parent = (pos - 1) / 2;
+        int32_t parent_slot = (int32_t)slide->cands[parent].heap_slot;
+        
+        if (!slide_ranks_above(slide, slot, parent_slot)) {
+            break;
+        }
+        slide_heap_place(slide, pos, parent_slot);
+        pos = parent;
+    }
+    
+    for (;;) {
+        int32_t child = (2 * pos) + 1;
+        int32_t child_slot;
+        
+        if (child >= slide->cand_count) {
+            break;
+        }
+        if (((child + 1) < slide->cand_count) &&
+            slide_ranks_above(slide, (int32_t)slide->cands[child + 1].heap_slot,
+                              (int32_t)slide->cands[child].heap_slot)) {
+            child++;
+        }
+        child_slot = (int32_t)slide->cands[child].heap_slot;
+        if (!slide_ranks_above(slide, child_slot, slot)) {
+            break;
+        }
+        slide_heap_place(slide, pos, child_slot);
+        pos = child;
+    }
+    
+    slide_heap_place(slide, pos, slot);
+}
+
+/*!
+ * @brief Recompute a candidate's prominence and move it in the heap.
+ */
+static void slide_rank(PeakSlideFP *slide, int32_t slot)
+{
+    PeakSlideCandidateFP *cand = &slide->cands[slot];
+    int32_t value = slide_at(slide, slide_index(slide, cand));
+    int32_t ref_level = (cand->left_min_q16 > cand->right_min_q16) ?
+                        cand->left_min_q16 : cand->right_min_q16;
+    int32_t prominence = q16_sub_sat(value, ref_level);
+    
+    if (prominence != cand->prominence_q16) {
+        cand->prominence_q16 = prominence;
+        slide_heap_fix(slide, (int32_t)cand->heap_pos);
+    }
+}
+
+/*!
+ * @brief Remove a candidate from the list of open right walks.
+ */
+static void slide_open_unlink(PeakSlideFP *slide, int32_t slot)
+{
+    PeakSlideCandidateFP *cand = &slide->cands[slot];
+    
+    if (cand->open_up == PEAK_INDEX_NONE) {
+        slide->open_top = cand->open_down;
+    } else {
+        slide->cands[cand->open_up].open_down = cand->open_down;
+    }
+    if (cand->open_down == PEAK_INDEX_NONE) {
+        slide->open_bottom = cand->open_up;
+    } else {
+        slide->cands[cand->open_down].open_up = cand->open_up;
+    }
+    cand->open_up = PEAK_INDEX_NONE;
+    cand->open_down = PEAK_INDEX_NONE;
+}
+
+/*!
+ * @brief Extend the open right walks over the hop samples from first.
+ *
+ * Open walks belong to peaks higher than every later sample, so they
+ * fall from the bottom of the list to its top while their minima rise:
+ * new samples stop them from the top, and the block minimum lowers them
+ * from the top until one is unchanged. A walk whose minimum falls below
+ * the cached left minimum no longer sets the reference level and is
+ * dropped from the list for good (left minima only rise).
+ */
+static void slide_extend_open(PeakSlideFP *slide, int32_t first)
+{
+    const PeakSlideBlockFP *block;
+    int32_t run_min = INT32_MAX;
+    int32_t a;
+    int32_t slot;
+    
+    if (slide->open_top == PEAK_INDEX_NONE) {
+        return;
+    }
+    
+    block = &slide->blocks[(first / slide->hop) % (slide->window / slide->hop)];
+    slot = (int32_t)slide->open_top;
+    if (block->max_q16 < slide_at(slide, slide_index(slide, &slide->cands[slot]))) {
+        STATS_ADD(walk_steps_right, 1);
+        run_min = block->min_q16;
+    } else {
+        for (a = first; a < (first + slide->hop); a++) {
+            int32_t sample = slide_at(slide, a);
+            
+            STATS_ADD(walk_steps_right, 1);
+            while ((slide->open_top != PEAK_INDEX_NONE) &&
+                   (slide_at(slide, slide_index(slide, &slide->cands[slide->open_top])) <= sample)) {
+                PeakSlideCandidateFP *cand = &slide->cands[slide->open_top];
+                
+                slot = (int32_t)slide->open_top;
+                cand->right_min_q16 = (run_min < cand->right_min_q16) ? run_min : cand->right_min_q16;
+                slide_open_unlink(slide, slot);
+                slide_rank(slide, slot);
+            }
+            run_min = (sample < run_min) ? sample : run_min;
+        }
+    }
+    
+    slot = (slide->open_top == PEAK_INDEX_NONE) ? -1 : (int32_t)slide->open_top;
+    while ((slot >= 0) && (slide->cands[slot].right_min_q16 > run_min)) {
+        PeakSlideCandidateFP *cand = &slide->cands[slot];
+        int32_t next = (cand->open_down == PEAK_INDEX_NONE) ? -1 : (int32_t)cand->open_down;
+        
+        cand->right_min_q16 = run_min;
+        if (run_min < cand->left_min_q16) {
+            cand->right_min_q16 = INT32_MIN;
+            slide_open_unlink(slide, slot);
+        }
+        slide_rank(slide, slot);
+        slot = next;
+    }
+}
+
+/*!
+ * @brief Candidate test of find_peak_candidates() at stream index a.
+ */
+static bool slide_is_candidate(const PeakSlideFP *slide, int32_t a)
+{
+    const PeakConfigFP *config = slide->config;
+    int32_t x_prev = slide_at(slide, a - 1);
+    int32_t x = slide_at(slide, a);
+    int32_t x_next = slide_at(slide, a + 1);
+    int32_t grad_prev;
+    int32_t grad_curr = q16_half_diff(x_next, x_prev);
+    
+    if ((a - 1) == slide->start) {
+        grad_prev = q16_sub_sat(x, x_prev);  /* Forward difference at the window start */
+    } else {
+        grad_prev = q16_half_diff(x, slide_at(slide, a - 2));
+    }
+    
+    bool is_zero_crossing = (grad_prev > 0) && (grad_curr <= 0);
+    bool is_local_max = (x > x_prev) && (x > x_next);
+    bool above_noise = (x > config->noise_floor_q16);
+    int32_t grad_mag = (grad_prev > 0) ? grad_prev : -grad_prev;
+    bool strong_gradient = (grad_mag >= config->gradient_threshold_q16);
+    
+    return (is_zero_crossing || is_local_max) && above_noise && strong_gradient;
+}
+
+/*!
+ * @brief Walk a new candidate at index a in ring slot slot and rank it.
+ *
+ * The heap grows by one. An open right walk joins the open list at the
+ * top, or at the bottom for the candidate next to the window start.
+ */
+static void slide_add_candidate(PeakSlideFP *slide, int32_t slot, int32_t a, bool at_bottom)
+{
+    PeakSlideCandidateFP *cand = &slide->cands[slot];
+    int32_t value = slide_at(slide, a);
+    
+    STATS_ADD(candidates_found, 1);
+    cand->index = (peak_stream_pos_t)a;
+    cand->open_up = PEAK_INDEX_NONE;
+    cand->open_down = PEAK_INDEX_NONE;
+    slide_walk_left(slide, cand);
+    if (!slide_walk_right(slide, cand)) {
+        if (cand->right_min_q16 < cand->left_min_q16) {
+            cand->right_min_q16 = INT32_MIN;
+        } else if (slide->open_top == PEAK_INDEX_NONE) {
+            slide->open_top = (peak_index_t)slot;
+            slide->open_bottom = (peak_index_t)slot;
+        } else if (at_bottom) {
+            cand->open_up = slide->open_bottom;
+            slide->cands[slide->open_bottom].open_down = (peak_index_t)slot;
+            slide->open_bottom = (peak_index_t)slot;
+        } else {
+            cand->open_down = slide->open_top;
+            slide->cands[slide->open_top].open_up = (peak_index_t)slot;
+            slide->open_top = (peak_index_t)slot;
+        }
+    }
+    
+    cand->prominence_q16 = q16_sub_sat(value, (cand->left_min_q16 > cand->right_min_q16) ?
+                                              cand->left_min_q16 : cand->right_min_q16);
+    slide_heap_place(slide, slide->cand_count, slot);
+    slide->cand_count++;
+    slide_heap_fix(slide, slide->cand_count - 1);
+}
+
+/*!
+ * @brief Drop the oldest candidate (deque head) from every structure.
+ */
+static void slide_drop_head(PeakSlideFP *slide)
+{
+    int32_t slot = slide->cand_head;
+    int32_t pos = (int32_t)slide->cands[slot].heap_pos;
+    
+    if (slide->open_bottom == (peak_index_t)slot) {
+        slide_open_unlink(slide, slot);
+    }
+    
+    slide->cand_count--;
+    if (pos < slide->cand_count) {
+        slide_heap_place(slide, pos, (int32_t)slide->cands[slide->cand_count].heap_slot);
+        slide_heap_fix(slide, pos);
+    }
+    slide->cand_head = (slide->cand_head + 1) % slide->cand_capacity;
+}
+
+/*!
+ * @brief Initialise a sliding-window detector.
+ *
+ * Each window gives the same result as find_prominent_peak_fp() on the
+ * window's samples. A hop converts and tests its hop samples, walks the
+ * candidates they add, and extends the right walks still open at the
+ * old end; the open walks are updated from the newest until one is
+ * unchanged, and a walk that can no longer set its candidate's
+ * reference level is closed, so this costs O(hop) plus O(1) amortised
+ * per candidate. Candidates are ranked in a max-heap of cached
+ * prominences. Losing samples on the left can only lower a prominence,
+ * so a cached value is an upper bound: only a candidate that reaches
+ * the top with its left stopper gone is walked again, until the top is
+ * exact. Walks cross hop blocks lower than the peak in one step, so one
+ * costs O(hop + window / hop), and a hop costs that per new or re-walked
+ * candidate plus O(log window) per heap change.
+ *
+ * @param slide Detector state (caller-owned)
+ * @param samples_q16 Caller storage of 2 * window entries
+ * @param blocks Caller storage of window / hop entries
+ * @param candidates Caller storage of PEAK_SLIDE_CANDIDATES(window) entries
+ * @param window Window length (>= 3, multiple of hop, at most
+ *        PEAK_SLIDE_REBASE_AT; at most 32767 in PEAK_FP_NARROW_INDEX builds)
+ * @param hop Samples per push (>= 1)
+ * @param user_config Optional configuration (NULL for default)
+ * @return PEAK_FP_OK on success, error code otherwise
+ */
+PeakResultFP peak_slide_init(PeakSlideFP *slide,
+                             peak_q_t samples_q16[],
+                             PeakSlideBlockFP blocks[],
+                             PeakSlideCandidateFP candidates[],
+                             int32_t window,
+                             int32_t hop,
+                             const PeakConfigFP *user_config)
+{
+    if ((slide == NULL) || (samples_q16 == NULL) || (blocks == NULL) ||
+        (candidates == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if ((hop < 1) || (window < hop) || ((window % hop) != 0) ||
+        (window > (PEAK_INDEX_MAX / 2)) || (window > PEAK_SLIDE_REBASE_AT)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    if (window < 3) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+    
+    slide->samples_q16 = samples_q16;
+    slide->blocks = blocks;
+    slide->cands = candidates;
+    slide->cand_capacity = PEAK_SLIDE_CANDIDATES(window);
+    slide->cand_head = 0;
+    slide->cand_count = 0;
+    slide->open_top = PEAK_INDEX_NONE;
+    slide->open_bottom = PEAK_INDEX_NONE;
+    slide->window = window;
+    slide->hop = hop;
+    slide->start = 0;
+    slide->received = 0;
+    slide->origin = 0U;
+    slide->config = (user_config != NULL) ? user_config : &default_config_fp;
+    
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Push hop samples and evaluate the window ending with them.
+ *
+ * In PEAK_FP_ENABLE_STATS builds candidates_found counts the candidates
+ * walked by this call and walk_steps_* the samples and blocks crossed.
+ *
+ * @param slide Detector state
+ * @param samples hop new samples
+ * @param peak_index Output: stream index (modulo 2^31) of the most
+ *        prominent peak in the current window, which starts at
+ *        peak_slide_window_start()
+ * @return PEAK_FP_OK if peak found, PEAK_FP_BUFFER_TOO_SMALL until the
+ *         first window is full, PEAK_FP_NO_PEAK_FOUND otherwise
+ */
+PeakResultFP peak_slide_push(PeakSlideFP *slide,
+                             const int16_t samples[],
+                             int32_t *peak_index)
+{
+    PeakSlideCandidateFP *best;
+    int32_t best_idx;
+    int32_t a;
+    
+    if ((slide == NULL) || (samples == NULL) || (peak_index == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    
+    STATS_RESET();
+    
+    if (slide->received < slide->window) {
+        /* Filling the first window */
+        slide_append(slide, samples, slide->received);
+        slide->received += slide->hop;
+        if (slide->received < slide->window) {
+            return PEAK_FP_BUFFER_TOO_SMALL;
+        }
+        
+        for (a = 1; a < (slide->window - 1); a++) {
+            if (slide_is_candidate(slide, a)) {
+                slide_add_candidate(slide, slide->cand_count, a, false);
+            }
+        }
+    } else {
+        int32_t old_end;
+        
+        if (slide->start >= PEAK_SLIDE_REBASE_AT) {
+            slide_rebase(slide);
+        }
+        old_end = slide->start + slide->window;
+        
+        slide_append(slide, samples, old_end);
+        slide->received += slide->hop;
+        slide->start += slide->hop;
+        
+        /* Leaving samples: drop candidates at window positions 0 and 1 */
+        while ((slide->cand_count > 0) &&
+               (slide_index(slide, &slide->cands[slide->cand_head]) <= (slide->start + 1))) {
+            slide_drop_head(slide);
+        }
+        
+        slide_extend_open(slide, old_end);
+        
+        /* Position 1 depends on the window edge (forward difference at 0) */
+        a = slide->start + 1;
+        if (slide_is_candidate(slide, a)) {
+            slide->cand_head = (slide->cand_head + slide->cand_capacity - 1) % slide->cand_capacity;
+            slide_add_candidate(slide, slide->cand_head, a, true);
+        }
+        
+        /* Entering samples: the old last sample and the new ones */
+        a = ((old_end - 1) > (slide->start + 2)) ? (old_end - 1) : (slide->start + 2);
+        for (; a < (slide->start + slide->window - 1); a++) {
+            if (slide_is_candidate(slide, a)) {
+                slide_add_candidate(slide,
+                                    (slide->cand_head + slide->cand_count) % slide->cand_capacity,
+                                    a, false);
+            }
+        }
+    }
+    
+    if (slide->cand_count == 0) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+    
+    /* Same selection as select_prominent_peak(): refresh stale left walks
+       at the top until the top is exact */
+    for (;;) {
+        int32_t slot = (int32_t)slide->cands[0].heap_slot;
+        
+        best = &slide->cands[slot];
+        best_idx = slide_index(slide, best);
+        if ((best_idx - (int32_t)best->left_span) >= (slide->start - 1)) {
+            break;
+        }
+        STATS_ADD(candidates_found, 1);
+        slide_walk_left(slide, best);
+        slide_rank(slide, slot);
+    }
+    
+    if (best->prominence_q16 < slide->config->prominence_threshold_q16) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+    
+    *peak_index = (int32_t)((slide->origin + (uint32_t)best_idx) & PEAK_STREAM_INDEX_MASK);
+    
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Stream index (modulo 2^31) of the first sample of the window
+ *        evaluated by the last peak_slide_push().
+ */
+int32_t peak_slide_window_start(const PeakSlideFP *slide)
+{
+    if (slide == NULL) {
+        return 0;
+    }
+    
+    return (int32_t)((slide->origin + (uint32_t)slide->start) & PEAK_STREAM_INDEX_MASK);
+}
+
+#ifdef PEAK_FP_ENABLE_STATS
+/*!
+ * @brief Read the instrumentation counters of the last frame call.
+ *
+ * Counters are reset at the start of every batch entry point:
+ * find_prominent_peak_fp(), find_prominent_peak_fp_buffered(),
+ * find_prominent_peak_fp_spans(), find_prominent_peak_fp_circular(),
+ * find_prominent_peak_fp_roi() and find_prominent_peak_pipeline_fp(),
+ * and of peak_slide_push(). Only available in builds with
+ * PEAK_FP_ENABLE_STATS; the counters are shared, so read them from the
+ * thread that made the call.
+ *
+ * @param stats Output: copy of the counters
+ */
+void peak_fp_get_stats(PeakStatsFP *stats)
+{
+    if (stats != NULL) {
+        *stats = s_stats;
+    }
 }
+#endif
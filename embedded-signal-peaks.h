@@ -0,0 +1,497 @@
+/*!
+ * Fixed-Point Adaptive Peak Finding - Public Interface
+ *
+ * Author: Tugbars Heptaskin
+ * Date: 11/11/2025
+ *
+ * MISRA C compliant with true MATLAB-compatible topological prominence.
+ * Optimized for embedded systems with limited stack space.
+ */
+
+#ifndef EMBEDDED_SIGNAL_PEAKS_H
+#define EMBEDDED_SIGNAL_PEAKS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Q16.16 Fixed-Point Configuration */
+#define Q16_SHIFT (16)
+#define Q16_ONE (1L << Q16_SHIFT)
+#define Q16_HALF (1L << (Q16_SHIFT - 1))
+
+/*!
+ * Detector Q format (build time). The working buffers, thresholds and
+ * prominences (the *_q16 fields) all use it; the field names keep their
+ * Q16 suffix. Q16_ONE above stays Q16.16 for the companion modules.
+ *
+ *   PEAK_Q_16_16  int32 buffers, 1.0 = one sample step (default)
+ *   PEAK_Q_24_8   int32 buffers, 1.0 = one sample step; full-scale
+ *                 differences never saturate
+ *   PEAK_Q_8_8    int16 buffers, 1.0 = one sample step; every path
+ *                 clamps samples to -128..127 before use (and reports
+ *                 the clamped value), so larger signals lose their peaks
+ *   PEAK_Q_1_15   int16 buffers, 1.0 = full scale; samples used as-is
+ */
+#define PEAK_Q_16_16 (0)
+#define PEAK_Q_24_8 (1)
+#define PEAK_Q_8_8 (2)
+#define PEAK_Q_1_15 (3)
+
+#ifndef PEAK_FP_Q_FORMAT
+#define PEAK_FP_Q_FORMAT PEAK_Q_16_16
+#endif
+
+#if PEAK_FP_Q_FORMAT == PEAK_Q_16_16
+#define PEAK_Q_SHIFT (16)
+#define PEAK_Q_SAMPLE_SHIFT (16)
+typedef int32_t peak_q_t;
+#elif PEAK_FP_Q_FORMAT == PEAK_Q_24_8
+#define PEAK_Q_SHIFT (8)
+#define PEAK_Q_SAMPLE_SHIFT (8)
+typedef int32_t peak_q_t;
+#elif PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+#define PEAK_Q_SHIFT (8)
+#define PEAK_Q_SAMPLE_SHIFT (8)
+typedef int16_t peak_q_t;
+#elif PEAK_FP_Q_FORMAT == PEAK_Q_1_15
+#define PEAK_Q_SHIFT (15)
+#define PEAK_Q_SAMPLE_SHIFT (0)
+typedef int16_t peak_q_t;
+#else
+#error "Unknown PEAK_FP_Q_FORMAT"
+#endif
+
+#define PEAK_Q_ONE (1L << PEAK_Q_SHIFT)
+#define PEAK_Q_SAMPLE_ONE (1L << PEAK_Q_SAMPLE_SHIFT)  /* One input LSB */
+
+/* Threshold helpers: sample steps, or real values, in the detector format */
+#define PEAK_Q_SAMPLES(n) ((int32_t)((n) * PEAK_Q_SAMPLE_ONE))
+#define PEAK_Q_FROM_FLOAT(x) ((int32_t)((x) * (float)PEAK_Q_ONE))
+
+/* Buffer sizes - adjust for your system */
+#ifndef MAX_SIGNAL_LENGTH
+#define MAX_SIGNAL_LENGTH (512)
+#endif
+#ifndef MAX_PEAKS
+#define MAX_PEAKS (32)
+#endif
+
+/* Candidate bitmap words for n samples (one bit per sample) */
+#define PEAK_BITMAP_WORDS(n) (((n) + 31) / 32)
+
+/*!
+ * Index width of the scratch structures (build time). With
+ * -DPEAK_FP_NARROW_INDEX the sliding-window candidates and ping-pong
+ * stack entries store indices as uint16_t,
+ * packed in pairs into 32-bit words. Stream engines store the low bits
+ * of a stream position (peak_stream_pos_t: 16 if narrow, otherwise 32)
+ * and rebuild it from their current position. The public API
+ * (PeakInfoFP, peak_index arguments) stays int32_t.
+ *
+ * Narrow builds limit a sliding window to 32767 samples and a ping-pong
+ * horizon to 65534 samples.
+ */
+#ifdef PEAK_FP_NARROW_INDEX
+typedef uint16_t peak_index_t;
+typedef uint16_t peak_stream_pos_t;
+#define PEAK_INDEX_NONE (0xFFFF)
+#define PEAK_INDEX_MAX (0xFFFE)
+#else
+typedef int32_t peak_index_t;
+typedef uint32_t peak_stream_pos_t;
+#define PEAK_INDEX_NONE (-1)
+#define PEAK_INDEX_MAX (INT32_MAX)
+#endif
+
+/* Arena allocation granularity (bytes, power of two) */
+#ifndef PEAK_ARENA_ALIGN
+#define PEAK_ARENA_ALIGN (8U)
+#endif
+
+/*!
+ * Cycle counter used by the instrumentation build (PEAK_FP_ENABLE_STATS).
+ * Override with a project-specific source if needed; on Cortex-M the DWT
+ * cycle counter must be enabled by the application. Other builds never
+ * read it, so no target header is pulled in.
+ */
+#if defined(PEAK_FP_ENABLE_STATS) && !defined(PEAK_FP_CYCLES)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PEAK_FP_CYCLES() ((uint32_t)__rdtsc())
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define PEAK_FP_CYCLES() (*(volatile const uint32_t *)0xE0001004UL)  /* DWT_CYCCNT */
+#else
+#define PEAK_FP_CYCLES() (0U)
+#endif
+#endif
+
+/* Configuration constants (detector format, in sample steps). The gradient
+ * threshold is at least 1 LSB: 0.1 of a Q1.15 step truncates to 0, which
+ * would pass flat runs. */
+#define PROMINENCE_THRESHOLD_Q16 ((int32_t)(1.0f * PEAK_Q_SAMPLE_ONE))
+#define GRADIENT_THRESHOLD_Q16 \
+    ((int32_t)((PEAK_Q_SAMPLE_ONE >= 10L) ? (PEAK_Q_SAMPLE_ONE / 10L) : 1L))
+#define NOISE_FLOOR_Q16 ((int32_t)(10.0f * PEAK_Q_SAMPLE_ONE))
+
+/* Return codes */
+typedef enum {
+    PEAK_FP_OK = 0,
+    PEAK_FP_NO_PEAK_FOUND = 1,
+    PEAK_FP_INVALID_INPUT = 2,
+    PEAK_FP_BUFFER_TOO_SMALL = 3
+} PeakResultFP;
+
+/* Configuration struct */
+typedef struct {
+    int32_t prominence_threshold_q16;
+    int32_t gradient_threshold_q16;
+    int32_t noise_floor_q16;
+} PeakConfigFP;
+
+/* Detected peak description */
+typedef struct {
+    int32_t index;           /* Sample index of the peak */
+    int16_t value;           /* Sample value at the peak (clamped under Q8.8) */
+    int32_t prominence_q16;  /* Topological prominence (detector Q format, saturates at INT32_MAX) */
+} PeakInfoFP;
+
+/*!
+ * Per-call instrumentation counters (PEAK_FP_ENABLE_STATS builds only).
+ *
+ * Cycle fields use PEAK_FP_CYCLES().
+ */
+typedef struct {
+    uint32_t cycles_convert;      /* int16 -> Q16.16 conversion */
+    uint32_t cycles_candidates;   /* find_peak_candidates() (fused loop for the pipeline) */
+    uint32_t cycles_prominence;   /* Prominence walks and selection */
+    int32_t candidates_found;     /* Candidates kept for evaluation */
+    int32_t walk_steps_left;      /* Samples crossed by left contour walks */
+    int32_t walk_steps_right;     /* Samples crossed by right contour walks */
+} PeakStatsFP;
+
+/*!
+ * Lazy peak iterator state.
+ *
+ * Works directly on the int16_t samples, so no conversion buffer is
+ * needed and the signal length is not limited by MAX_SIGNAL_LENGTH.
+ * Treat the fields as private; they are exposed only so the iterator
+ * can live on the caller's stack.
+ */
+typedef struct {
+    const int16_t *signal;
+    int32_t length;
+    const PeakConfigFP *config;
+    int32_t position;        /* Next sample to test */
+    int32_t grad_prev;       /* Gradient at position - 1 (Q16.16) */
+    int32_t candidates;      /* Candidates evaluated so far */
+} PeakIteratorFP;
+
+/*!
+ * Stream indices. The streaming engines count samples in uint32_t, so
+ * the count wraps without overflow, and report indices modulo 2^31 so
+ * they stay non-negative in int32_t fields (about 6 h at 100 kHz before
+ * the first wrap). Take differences of stream indices modulo 2^31:
+ * ((a - b) & PEAK_STREAM_INDEX_MASK).
+ */
+#define PEAK_STREAM_INDEX_MASK (0x7FFFFFFFU)
+
+/*!
+ * Resumable streaming detector state.
+ *
+ * Samples fed in arbitrary blocks are collected into a caller-provided
+ * frame; completed frames are scanned lazily with PeakIteratorFP. A frame
+ * contained entirely in the fed block is scanned in place without copying.
+ * Treat the fields as private.
+ */
+typedef struct {
+    int16_t *frame;            /* Caller-provided frame storage */
+    int32_t frame_length;
+    int32_t fill;              /* Samples collected in frame */
+    const int16_t *pending;    /* Unconsumed part of the fed block */
+    int32_t pending_count;
+    uint32_t frame_start;      /* Samples before frame[0] (wraps) */
+    bool frame_ready;          /* Frame complete, peaks being yielded */
+    bool in_place;             /* Ready frame is scanned inside pending */
+    PeakIteratorFP iter;
+    const PeakConfigFP *config;
+} PeakStreamFP;
+
+/*!
+ * Monotonic (bump) arena over caller-provided memory. Allocations are
+ * released all at once with peak_arena_reset(), typically per frame.
+ */
+typedef struct {
+    uint8_t *base;
+    size_t capacity;
+    size_t used;
+} PeakArenaFP;
+
+/* Peak list allocated from a PeakArenaFP */
+typedef struct {
+    PeakInfoFP *peaks;
+    int32_t count;
+} PeakListFP;
+
+/*!
+ * Fused preprocessing stages, applied in order smooth -> detrend -> peaks.
+ * A zero field disables its stage.
+ */
+typedef struct {
+    int32_t smooth_half_width;  /* Centred moving average over 2*w+1 samples */
+    int32_t detrend_shift;      /* EMA baseline removal, alpha = 2^-shift (1..15) */
+} PeakPipelineFP;
+
+/* Half-open sample interval [start, end) */
+typedef struct {
+    int32_t start;
+    int32_t end;
+} PeakIntervalFP;
+
+/* How a region-of-interest mask selects samples */
+typedef enum {
+    PEAK_ROI_INCLUDE = 0,    /* Only the listed samples are scanned */
+    PEAK_ROI_EXCLUDE = 1     /* The listed samples are skipped */
+} PeakRoiModeFP;
+
+/*!
+ * Region-of-interest mask, given either as sorted, non-overlapping
+ * intervals or as a bitmap (bit i % 32 of word i / 32 lists sample i).
+ * Each maximal run of scanned samples is evaluated as a frame of its
+ * own: candidates and contour walks never cross a skipped sample.
+ */
+typedef struct {
+    PeakRoiModeFP mode;
+    const PeakIntervalFP *intervals;  /* Used when bitmap is NULL */
+    int32_t interval_count;
+    const uint32_t *bitmap;           /* (length + 31) / 32 words, or NULL */
+} PeakRoiFP;
+
+/* Ping-pong stack entry flags */
+#define PEAK_PP_CANDIDATE (0x01U)
+#define PEAK_PP_REPORTED (0x02U)
+#define PEAK_PP_EXPIRED (0x04U)   /* Older than the horizon */
+
+/*!
+ * Monotonic-stack entry of the ping-pong detector (caller-provided
+ * storage; treat the fields as private).
+ */
+typedef struct {
+    peak_stream_pos_t index; /* Stream position of the sample (low bits) */
+    uint16_t flags;
+    int32_t value_q16;
+    int32_t left_min_q16;    /* Minimum of the finished left walk */
+    int32_t run_min_q16;     /* Minimum between this entry and the one above */
+} PeakStackEntryFP;
+
+/*!
+ * Continuous (unframed) detector for DMA half/full-transfer buffers.
+ *
+ * Every sample enters a monotonic stack of strictly decreasing values,
+ * so each left contour walk is finished when its sample arrives and each
+ * right walk ends when a sample at least as high pops it. A candidate
+ * whose right walk is still open horizon samples later is finalised with
+ * the walk truncated there, which bounds the reporting latency.
+ * Treat the fields as private.
+ */
+typedef struct {
+    PeakStackEntryFP *stack;  /* Ring; stack[bottom] is a sentinel */
+    int32_t bottom;           /* Slot of the sentinel */
+    int32_t depth;            /* Entries in use, including the sentinel */
+    int32_t capacity;
+    int32_t horizon;          /* Latency bound in samples */
+    uint32_t position;        /* Stream position of the next sample (wraps) */
+    int32_t primed;           /* Samples seen, saturating at 2 */
+    int32_t x_prev1_q16;      /* Sample at position - 1 */
+    int32_t x_prev2_q16;      /* Sample at position - 2 */
+    int32_t grad_prev;        /* Gradient at position - 2 */
+    PeakInfoFP *out;          /* Output of the current call */
+    int32_t out_capacity;
+    int32_t out_count;
+    bool out_overflow;
+    const PeakConfigFP *config;
+} PeakPingPongFP;
+
+/* Candidate storage needed by a sliding window of w samples (a local
+ * maximum and a gradient zero crossing can be adjacent) */
+#define PEAK_SLIDE_CANDIDATES(w) ((w) - 2)
+
+/* Local window start at which a sliding window rebases its counters
+ * toward 0 (also the largest accepted window) */
+#ifndef PEAK_SLIDE_REBASE_AT
+#define PEAK_SLIDE_REBASE_AT (1L << 28)
+#endif
+
+/* Sliding-window candidate with cached contour walks (private) */
+typedef struct {
+    peak_stream_pos_t index; /* Local index (mod 2^16 if narrow) */
+    peak_index_t left_span;  /* index - left stopper (or window start - 1) */
+    peak_index_t open_up;    /* Open right walks: next newer, PEAK_INDEX_NONE at the top */
+    peak_index_t open_down;  /* Open right walks: next older, PEAK_INDEX_NONE at the bottom */
+    peak_index_t heap_pos;   /* Heap position of this candidate */
+    peak_index_t heap_slot;  /* Candidate at the heap position equal to this entry's offset */
+    int32_t left_min_q16;
+    int32_t right_min_q16;   /* INT32_MIN once it can no longer set the reference */
+    int32_t prominence_q16;  /* Upper bound until the left walk is refreshed */
+} PeakSlideCandidateFP;
+
+/* Per-hop block extremes used to skip whole blocks during walks */
+typedef struct {
+    int32_t min_q16;
+    int32_t max_q16;
+} PeakSlideBlockFP;
+
+/*!
+ * Sliding window of window samples advanced by hop samples per call.
+ *
+ * Samples are converted once into a double-mapped buffer (each stored
+ * at i and i + window), so the window is always contiguous. Candidate
+ * flags and contour walks are cached across hops and recomputed only
+ * where entering or leaving samples invalidate them; candidates are
+ * ranked by cached prominence in a max-heap kept inside the deque.
+ *
+ * Counters are local to origin; once start reaches PEAK_SLIDE_REBASE_AT
+ * a multiple of window is moved from them into origin, so streams of any
+ * length work. Reported indices are (origin + local) modulo 2^31.
+ * Treat the fields as private.
+ */
+typedef struct {
+    peak_q_t *samples_q16;         /* 2 * window entries */
+    PeakSlideBlockFP *blocks;      /* window / hop entries (ring) */
+    PeakSlideCandidateFP *cands;   /* PEAK_SLIDE_CANDIDATES(window) entries (deque and heap) */
+    int32_t cand_capacity;
+    int32_t cand_head;
+    int32_t cand_count;
+    peak_index_t open_top;         /* Newest candidate with an open right walk */
+    peak_index_t open_bottom;      /* Oldest candidate with an open right walk */
+    int32_t window;
+    int32_t hop;
+    int32_t start;                 /* Local index of the first window sample */
+    int32_t received;              /* Local index of the next sample */
+    uint32_t origin;               /* Stream position of local index 0 (wraps) */
+    const PeakConfigFP *config;
+} PeakSlideFP;
+
+PeakResultFP find_prominent_peak_fp(const int16_t signal[],
+                                     int32_t length,
+                                     int32_t *peak_index,
+                                     const PeakConfigFP *user_config);
+
+PeakResultFP find_prominent_peak_fp_buffered(const int16_t signal[],
+                                              int32_t length,
+                                              int32_t *peak_index,
+                                              const PeakConfigFP *user_config,
+                                              peak_q_t *signal_q16_buffer,
+                                              uint32_t *candidate_bitmap);
+
+PeakResultFP find_prominent_peak_fp_spans(const int16_t head[],
+                                           int32_t head_length,
+                                           const int16_t tail[],
+                                           int32_t tail_length,
+                                           int32_t *peak_index,
+                                           const PeakConfigFP *user_config);
+
+PeakResultFP find_prominent_peak_fp_circular(const int16_t signal[],
+                                              int32_t length,
+                                              int32_t *peak_index,
+                                              const PeakConfigFP *user_config);
+
+PeakResultFP find_prominent_peak_fp_roi(const int16_t signal[],
+                                         int32_t length,
+                                         const PeakRoiFP *roi,
+                                         int32_t *peak_index,
+                                         const PeakConfigFP *user_config);
+
+PeakResultFP find_periodic_peaks_fp(const int16_t signal[],
+                                    int32_t length,
+                                    int32_t period,
+                                    PeakInfoFP peaks[],
+                                    int32_t max_peaks,
+                                    int32_t *num_peaks,
+                                    const PeakConfigFP *user_config);
+
+PeakResultFP find_prominent_peak_pipeline_fp(const int16_t signal[],
+                                              int32_t length,
+                                              const PeakPipelineFP *pipeline,
+                                              int32_t *peak_index,
+                                              const PeakConfigFP *user_config);
+
+PeakResultFP peak_iter_init(PeakIteratorFP *iter,
+                            const int16_t signal[],
+                            int32_t length,
+                            const PeakConfigFP *user_config);
+
+PeakResultFP peak_iter_next(PeakIteratorFP *iter, PeakInfoFP *peak);
+
+PeakResultFP peak_stream_init(PeakStreamFP *stream,
+                              int16_t frame_buffer[],
+                              int32_t frame_length,
+                              const PeakConfigFP *user_config);
+
+PeakResultFP peak_stream_feed(PeakStreamFP *stream,
+                              const int16_t block[],
+                              int32_t count);
+
+PeakResultFP peak_stream_next(PeakStreamFP *stream, PeakInfoFP *peak);
+
+void peak_arena_init(PeakArenaFP *arena, void *memory, size_t capacity);
+
+void peak_arena_reset(PeakArenaFP *arena);
+
+void *peak_arena_alloc(PeakArenaFP *arena, size_t size);
+
+PeakResultFP find_peaks_arena_fp(const int16_t signal[],
+                                 int32_t length,
+                                 const PeakConfigFP *user_config,
+                                 PeakArenaFP *arena,
+                                 PeakListFP *list);
+
+PeakResultFP peak_pingpong_init(PeakPingPongFP *pp,
+                                PeakStackEntryFP stack[],
+                                int32_t stack_capacity,
+                                int32_t horizon,
+                                const PeakConfigFP *user_config);
+
+PeakResultFP peak_pingpong_process(PeakPingPongFP *pp,
+                                   const int16_t half[],
+                                   int32_t count,
+                                   PeakInfoFP peaks[],
+                                   int32_t max_peaks,
+                                   int32_t *num_peaks);
+
+PeakResultFP peak_pingpong_flush(PeakPingPongFP *pp,
+                                 PeakInfoFP peaks[],
+                                 int32_t max_peaks,
+                                 int32_t *num_peaks);
+
+PeakResultFP peak_slide_init(PeakSlideFP *slide,
+                             peak_q_t samples_q16[],
+                             PeakSlideBlockFP blocks[],
+                             PeakSlideCandidateFP candidates[],
+                             int32_t window,
+                             int32_t hop,
+                             const PeakConfigFP *user_config);
+
+PeakResultFP peak_slide_push(PeakSlideFP *slide,
+                             const int16_t samples[],
+                             int32_t *peak_index);
+
+int32_t peak_slide_window_start(const PeakSlideFP *slide);
+
+#ifdef PEAK_FP_ENABLE_STATS
+void peak_fp_get_stats(PeakStatsFP *stats);
+#endif
+
+float get_peak_prominence_float(const int16_t signal[],
+                                 int32_t length,
+                                 int32_t peak_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EMBEDDED_SIGNAL_PEAKS_H */
@@ -0,0 +1,603 @@
+/*!
+ * Differential Fuzzing Harness for embedded-signal-peaks
+ *
+ * Feeds the same signal and configuration to the reference scalar path
+ * (find_prominent_peak_fp() and get_peak_prominence_float(), i.e. the
+ * original contour walker) and to every alternative path, and aborts on
+ * any difference in peak index or prominence. Each call is also timed
+ * against a budget scaled to its expected work (n log n plus the walks of
+ * the reference), so performance cliffs crash the fuzzer just like wrong
+ * answers.
+ *
+ * Input layout: byte 0 selects the configuration, bytes 1..3 the
+ * threshold scaling, the rest are little-endian int16_t samples.
+ *
+ * libFuzzer: clang -g -O1 -fsanitize=fuzzer,address,undefined \
+ *                -DPEAK_FP_FUZZ_LIBFUZZER fuzz-differential.c embedded-signal-peaks.c
+ * Standalone: gcc -O2 -o fuzz-differential fuzz-differential.c embedded-signal-peaks.c
+ *             ./fuzz-differential [iterations] [seed]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "embedded-signal-peaks.h"
+
+/* Longest input exercised by the streaming/iterator paths */
+#define FUZZ_MAX_SAMPLES (4096)
+
+/* Time budget per call: fixed overhead plus an allowance per unit of
+ * expected work, n*log2(n) for the scan plus the contour-walk steps the
+ * reference takes on the same input. A path that does more than a
+ * constant factor of that work fails even where the reference is linear.
+ * Calibrated on long inputs: -O2 builds take under 3 ns per unit, ASan
+ * and UBSan builds under 20. */
+#ifndef FUZZ_BUDGET_BASE_NS
+#define FUZZ_BUDGET_BASE_NS (2000000ULL)
+#endif
+#ifndef FUZZ_BUDGET_NS_PER_UNIT
+#define FUZZ_BUDGET_NS_PER_UNIT (50ULL)
+#endif
+
+/* Allow full-scale int16 inputs (differences beyond the Q16.16 range) */
+#ifndef FUZZ_FULL_SCALE
+#define FUZZ_FULL_SCALE (1)
+#endif
+
+static int16_t s_signal[FUZZ_MAX_SAMPLES];
+static int16_t s_frame[FUZZ_MAX_SAMPLES];
+static peak_q_t s_q16_buffer[MAX_SIGNAL_LENGTH];
+static uint32_t s_candidate_bitmap[PEAK_BITMAP_WORDS(MAX_SIGNAL_LENGTH)];
+static PeakInfoFP s_iter_peaks[FUZZ_MAX_SAMPLES];
+static PeakInfoFP s_pp_peaks[FUZZ_MAX_SAMPLES];
+static PeakStackEntryFP s_pp_stack[FUZZ_MAX_SAMPLES + 2];
+static peak_q_t s_slide_samples[2 * MAX_SIGNAL_LENGTH];
+static PeakSlideBlockFP s_slide_blocks[MAX_SIGNAL_LENGTH];
+static PeakSlideCandidateFP s_slide_cands[PEAK_SLIDE_CANDIDATES(MAX_SIGNAL_LENGTH)];
+static PeakIntervalFP s_roi_intervals[16];
+static uint32_t s_roi_bitmap[(MAX_SIGNAL_LENGTH + 31) / 32];
+static uint64_t s_arena_memory[FUZZ_MAX_SAMPLES * 2];
+static uint64_t s_walk_steps;
+
+/* Thread CPU time, so preemption does not count against the budget */
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void fuzz_fail(const char *what, int32_t length, int32_t expected, int32_t actual)
+{
+    fprintf(stderr, "DIVERGENCE: %s (length %d): expected %d, got %d\n",
+            what, length, expected, actual);
+    abort();
+}
+
+/*!
+ * @brief Fail if a call over length samples took longer than its budget.
+ *
+ * Calls that see less than the whole input (a sliding window) are still
+ * allowed the walks of the whole input, an upper bound on their own.
+ */
+static void check_budget(const char *what, int32_t length, uint64_t elapsed_ns)
+{
+    uint64_t n = (uint64_t)length;
+    uint64_t log2n = 1U;
+    uint64_t budget;
+
+    while ((1ULL << log2n) < n) {
+        log2n++;
+    }
+    budget = FUZZ_BUDGET_BASE_NS + (FUZZ_BUDGET_NS_PER_UNIT * ((n * log2n) + s_walk_steps));
+
+    if (elapsed_ns > budget) {
+        fprintf(stderr, "PERFORMANCE CLIFF: %s (length %d): %llu ns > budget %llu ns\n",
+                what, length, (unsigned long long)elapsed_ns, (unsigned long long)budget);
+        abort();
+    }
+}
+
+/*!
+ * @brief Reference prominence of one index, in Q16.16.
+ *
+ * get_peak_prominence_float() runs the original walker; integer inputs
+ * make the result an exact multiple of one sample step, so the float is
+ * exact. The Q16.16 paths saturate full-scale prominences at INT32_MAX.
+ */
+static int32_t reference_prominence(const int16_t signal[], int32_t length, int32_t index)
+{
+    int64_t prominence = (int64_t)((double)get_peak_prominence_float(signal, length, index) * PEAK_Q_ONE);
+
+    return (prominence > INT32_MAX) ? INT32_MAX : (int32_t)prominence;
+}
+
+/*!
+ * @brief Contour-walk steps of the reference on the whole input.
+ *
+ * The iterator with no prominence threshold enumerates the candidates;
+ * each walk is replayed on the samples as the reference walker runs it.
+ */
+static uint64_t reference_walk_steps(int32_t length, const PeakConfigFP *config)
+{
+    PeakConfigFP all = { PROMINENCE_THRESHOLD_Q16, GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    uint64_t steps = 0U;
+    int32_t k;
+
+    if (config != NULL) {
+        all = *config;
+    }
+    all.prominence_threshold_q16 = INT32_MIN;
+
+    if (peak_iter_init(&iter, s_signal, length, &all) != PEAK_FP_OK) {
+        return 0U;
+    }
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        for (k = peak.index - 1; (k >= 0) && (s_signal[k] < s_signal[peak.index]); k--) {
+            steps++;
+        }
+        for (k = peak.index + 1; (k < length) && (s_signal[k] < s_signal[peak.index]); k++) {
+            steps++;
+        }
+    }
+
+    return steps;
+}
+
+/*!
+ * @brief Stream the input in blocks and compare with the iterator peaks.
+ */
+static void check_stream(int32_t length, const PeakConfigFP *config,
+                         int32_t block, int32_t num_iter)
+{
+    PeakStreamFP stream;
+    PeakInfoFP peak;
+    int32_t n = 0;
+    int32_t pos;
+    uint64_t t0;
+
+    if (peak_stream_init(&stream, s_frame, length, config) != PEAK_FP_OK) {
+        return;
+    }
+
+    t0 = now_ns();
+    for (pos = 0; pos < length; pos += block) {
+        (void)peak_stream_feed(&stream, &s_signal[pos],
+                               ((length - pos) < block) ? (length - pos) : block);
+        while (peak_stream_next(&stream, &peak) == PEAK_FP_OK) {
+            if ((n >= num_iter) || (peak.index != s_iter_peaks[n].index) ||
+                (peak.prominence_q16 != s_iter_peaks[n].prominence_q16)) {
+                fuzz_fail("peak_stream peak", length,
+                          (n < num_iter) ? s_iter_peaks[n].index : -1, peak.index);
+            }
+            n++;
+        }
+    }
+    check_budget("peak_stream", length, now_ns() - t0);
+    if (n != num_iter) {
+        fuzz_fail("peak_stream count", length, num_iter, n);
+    }
+}
+
+/*!
+ * @brief Ping-pong detector over the whole input, fed in halves.
+ *
+ * With a horizon covering the input nothing is truncated, so after a
+ * flush the peaks (sorted by index) must equal the iterator's.
+ */
+static void check_pingpong(int32_t length, const PeakConfigFP *config,
+                           int32_t half, int32_t num_iter)
+{
+    PeakPingPongFP pp;
+    int32_t n = 0;
+    int32_t got;
+    int32_t pos;
+    int32_t i;
+    uint64_t t0;
+
+    if (peak_pingpong_init(&pp, s_pp_stack, length + 2, length, config) != PEAK_FP_OK) {
+        return;
+    }
+
+    t0 = now_ns();
+    for (pos = 0; pos < length; pos += half) {
+        got = 0;
+        (void)peak_pingpong_process(&pp, &s_signal[pos],
+                                    ((length - pos) < half) ? (length - pos) : half,
+                                    &s_pp_peaks[n], FUZZ_MAX_SAMPLES - n, &got);
+        n += got;
+    }
+    got = 0;
+    (void)peak_pingpong_flush(&pp, &s_pp_peaks[n], FUZZ_MAX_SAMPLES - n, &got);
+    n += got;
+    check_budget("peak_pingpong", length, now_ns() - t0);
+
+    if (n != num_iter) {
+        fuzz_fail("peak_pingpong count", length, num_iter, n);
+    }
+
+    /* Finalisation order differs from index order: insertion sort */
+    for (i = 1; i < n; i++) {
+        PeakInfoFP key = s_pp_peaks[i];
+        int32_t k = i - 1;
+
+        while ((k >= 0) && (s_pp_peaks[k].index > key.index)) {
+            s_pp_peaks[k + 1] = s_pp_peaks[k];
+            k--;
+        }
+        s_pp_peaks[k + 1] = key;
+    }
+
+    for (i = 0; i < n; i++) {
+        if ((s_pp_peaks[i].index != s_iter_peaks[i].index) ||
+            (s_pp_peaks[i].prominence_q16 != s_iter_peaks[i].prominence_q16)) {
+            fuzz_fail("peak_pingpong peak", length, s_iter_peaks[i].index, s_pp_peaks[i].index);
+        }
+    }
+}
+
+/*!
+ * @brief Sliding window with hop: every window must match a full call.
+ */
+static void check_slide(int32_t length, const PeakConfigFP *config, int32_t hop)
+{
+    PeakSlideFP slide;
+    int32_t window = hop * ((length / 2) / hop);
+    int32_t pos;
+
+    window = (window > MAX_SIGNAL_LENGTH) ? (hop * (MAX_SIGNAL_LENGTH / hop)) : window;
+    if (peak_slide_init(&slide, s_slide_samples, s_slide_blocks, s_slide_cands,
+                        window, hop, config) != PEAK_FP_OK) {
+        return;
+    }
+
+    for (pos = 0; (pos + hop) <= length; pos += hop) {
+        int32_t ref_idx = -1;
+        int32_t slide_idx = -1;
+        PeakResultFP ref_result;
+        PeakResultFP slide_result;
+        uint64_t t0 = now_ns();
+
+        slide_result = peak_slide_push(&slide, &s_signal[pos], &slide_idx);
+        check_budget("peak_slide_push", window, now_ns() - t0);
+        if ((pos + hop) < window) {
+            continue;
+        }
+
+        ref_result = find_prominent_peak_fp(&s_signal[pos + hop - window], window, &ref_idx, config);
+        ref_idx += pos + hop - window;
+        if ((slide_result != ref_result) ||
+            ((ref_result == PEAK_FP_OK) && (slide_idx != ref_idx))) {
+            fuzz_fail("peak_slide_push", length, ref_idx, slide_idx);
+        }
+    }
+}
+
+/*!
+ * @brief Region-of-interest mask: must equal the best of separate calls
+ *        on each scanned run, for intervals and bitmaps, both modes.
+ */
+static void check_roi(int32_t length, const PeakConfigFP *config, int32_t split)
+{
+    uint32_t state = 0x9E3779B9U ^ ((uint32_t)split * 2654435761U) ^ (uint32_t)length;
+    int32_t count = 0;
+    int32_t pos = 0;
+    int32_t mode;
+    int32_t i;
+
+    /* Random sorted intervals, some empty or adjacent */
+    while ((count < 16) && (pos < length)) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        s_roi_intervals[count].start = pos + (int32_t)(state % 24U);
+        s_roi_intervals[count].start = (s_roi_intervals[count].start > length) ?
+                                       length : s_roi_intervals[count].start;
+        s_roi_intervals[count].end = s_roi_intervals[count].start + (int32_t)((state >> 8) % 64U);
+        s_roi_intervals[count].end = (s_roi_intervals[count].end > length) ?
+                                     length : s_roi_intervals[count].end;
+        pos = s_roi_intervals[count].end;
+        count++;
+    }
+
+    for (i = 0; i < ((length + 31) / 32); i++) {
+        s_roi_bitmap[i] = 0U;
+    }
+    for (i = 0; i < count; i++) {
+        int32_t k;
+        for (k = s_roi_intervals[i].start; k < s_roi_intervals[i].end; k++) {
+            s_roi_bitmap[k / 32] |= 1UL << (k % 32);
+        }
+    }
+
+    for (mode = 0; mode < 2; mode++) {
+        PeakRoiFP roi = { (mode == 0) ? PEAK_ROI_INCLUDE : PEAK_ROI_EXCLUDE,
+                          s_roi_intervals, count, NULL };
+        int32_t best_idx = -1;
+        int32_t best_prom = INT32_MIN;
+        int32_t run_start = -1;
+        int32_t got_idx = -1;
+        PeakResultFP result;
+        uint64_t t0;
+
+        /* Reference: every maximal run as its own frame */
+        for (i = 0; i <= length; i++) {
+            bool listed = (i < length) && ((s_roi_bitmap[i / 32] >> (i % 32)) & 1U);
+            bool scanned = (i < length) && (listed == (mode == 0));
+
+            if (scanned && (run_start < 0)) {
+                run_start = i;
+            } else if (!scanned && (run_start >= 0)) {
+                int32_t idx = -1;
+                if (find_prominent_peak_fp(&s_signal[run_start], i - run_start, &idx, config) == PEAK_FP_OK) {
+                    int32_t prom = reference_prominence(&s_signal[run_start], i - run_start, idx);
+                    if (prom > best_prom) {
+                        best_prom = prom;
+                        best_idx = run_start + idx;
+                    }
+                }
+                run_start = -1;
+            } else {
+                /* Inside a run or a gap */
+            }
+        }
+
+        t0 = now_ns();
+        result = find_prominent_peak_fp_roi(s_signal, length, &roi, &got_idx, config);
+        check_budget("find_prominent_peak_fp_roi", length, now_ns() - t0);
+        if ((result == PEAK_FP_OK) != (best_idx >= 0) ||
+            ((result == PEAK_FP_OK) && (got_idx != best_idx))) {
+            fuzz_fail("find_prominent_peak_fp_roi intervals", length, best_idx, got_idx);
+        }
+
+        roi.bitmap = s_roi_bitmap;
+        got_idx = -1;
+        result = find_prominent_peak_fp_roi(s_signal, length, &roi, &got_idx, config);
+        if ((result == PEAK_FP_OK) != (best_idx >= 0) ||
+            ((result == PEAK_FP_OK) && (got_idx != best_idx))) {
+            fuzz_fail("find_prominent_peak_fp_roi bitmap", length, best_idx, got_idx);
+        }
+    }
+}
+
+/*!
+ * @brief Run all paths on one signal/config and compare.
+ */
+static void fuzz_one(int32_t length, int32_t split, const PeakConfigFP *config)
+{
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    PeakArenaFP arena;
+    PeakListFP list;
+    PeakPipelineFP passthrough = { 0, 0 };
+    int32_t num_iter = 0;
+    int32_t best_iter = -1;
+    int32_t best_prom = INT32_MIN;
+    int32_t ref_idx = -1;
+    int32_t other_idx = -1;
+    PeakResultFP ref_result;
+    PeakResultFP other_result;
+    uint64_t t0;
+    int32_t i;
+
+    s_walk_steps = reference_walk_steps(length, config);
+
+    /* Lazy iterator: all peaks above threshold, in index order */
+    t0 = now_ns();
+    if (peak_iter_init(&iter, s_signal, length, config) == PEAK_FP_OK) {
+        while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+            s_iter_peaks[num_iter] = peak;
+            num_iter++;
+        }
+    }
+    check_budget("peak_iter", length, now_ns() - t0);
+
+    /* Every yielded peak must carry the reference prominence */
+    if (length <= MAX_SIGNAL_LENGTH) {
+        for (i = 0; i < num_iter; i++) {
+            int32_t expected = reference_prominence(s_signal, length, s_iter_peaks[i].index);
+            if (expected != s_iter_peaks[i].prominence_q16) {
+                fuzz_fail("peak_iter prominence", length, expected,
+                          s_iter_peaks[i].prominence_q16);
+            }
+            if (s_iter_peaks[i].prominence_q16 > best_prom) {
+                best_prom = s_iter_peaks[i].prominence_q16;
+                best_iter = s_iter_peaks[i].index;
+            }
+        }
+    }
+
+    /* Arena list must equal the iterator output */
+    peak_arena_init(&arena, s_arena_memory, sizeof(s_arena_memory));
+    t0 = now_ns();
+    (void)find_peaks_arena_fp(s_signal, length, config, &arena, &list);
+    check_budget("find_peaks_arena_fp", length, now_ns() - t0);
+    if (list.count != num_iter) {
+        fuzz_fail("find_peaks_arena_fp count", length, num_iter, list.count);
+    }
+    for (i = 0; i < list.count; i++) {
+        if ((list.peaks[i].index != s_iter_peaks[i].index) ||
+            (list.peaks[i].prominence_q16 != s_iter_peaks[i].prominence_q16)) {
+            fuzz_fail("find_peaks_arena_fp peak", length, s_iter_peaks[i].index,
+                      list.peaks[i].index);
+        }
+    }
+
+    /* Stream with a single frame spanning the input: fed in odd-sized
+     * blocks (copied into the frame) and as one block (scanned in place) */
+    check_stream(length, config, 13, num_iter);
+    check_stream(length, config, length, num_iter);
+    check_pingpong(length, config, 1 + (split % 64), num_iter);
+    check_slide(length, config, 1 + (split % 16));
+
+    if (length > MAX_SIGNAL_LENGTH) {
+        return;
+    }
+
+    /* Reference scalar path */
+    t0 = now_ns();
+    ref_result = find_prominent_peak_fp(s_signal, length, &ref_idx, config);
+    check_budget("find_prominent_peak_fp", length, now_ns() - t0);
+
+    /* Neither path caps the candidate count, so the best peaks must agree */
+    other_result = (best_iter >= 0) ? PEAK_FP_OK :
+                   ((length < 3) ? PEAK_FP_BUFFER_TOO_SMALL : PEAK_FP_NO_PEAK_FOUND);
+    if (other_result != ref_result) {
+        fuzz_fail("peak_iter best result", length, (int32_t)ref_result, (int32_t)other_result);
+    }
+    if ((ref_result == PEAK_FP_OK) && (best_iter != ref_idx)) {
+        fuzz_fail("peak_iter best index", length, ref_idx, best_iter);
+    }
+
+    /* Buffered variant */
+    other_idx = -1;
+    t0 = now_ns();
+    other_result = find_prominent_peak_fp_buffered(s_signal, length, &other_idx, config,
+                                                   s_q16_buffer, s_candidate_bitmap);
+    check_budget("find_prominent_peak_fp_buffered", length, now_ns() - t0);
+    if ((other_result != ref_result) || ((ref_result == PEAK_FP_OK) && (other_idx != ref_idx))) {
+        fuzz_fail("find_prominent_peak_fp_buffered", length, ref_idx, other_idx);
+    }
+
+    /* Two spans, split at a point derived from the input */
+    other_idx = -1;
+    t0 = now_ns();
+    other_result = find_prominent_peak_fp_spans(s_signal, split, &s_signal[split],
+                                                length - split, &other_idx, config);
+    check_budget("find_prominent_peak_fp_spans", length, now_ns() - t0);
+    if ((other_result != ref_result) || ((ref_result == PEAK_FP_OK) && (other_idx != ref_idx))) {
+        fuzz_fail("find_prominent_peak_fp_spans", length, ref_idx, other_idx);
+    }
+
+    check_roi(length, config, split);
+
+    /* Fused pipeline with all stages disabled */
+    other_idx = -1;
+    t0 = now_ns();
+    other_result = find_prominent_peak_pipeline_fp(s_signal, length, &passthrough,
+                                                   &other_idx, config);
+    check_budget("find_prominent_peak_pipeline_fp", length, now_ns() - t0);
+    if ((other_result != ref_result) || ((ref_result == PEAK_FP_OK) && (other_idx != ref_idx))) {
+        fuzz_fail("find_prominent_peak_pipeline_fp", length, ref_idx, other_idx);
+    }
+}
+
+/*!
+ * @brief Decode one fuzzer input and run the differential check.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    PeakConfigFP config;
+    int32_t length;
+    int32_t i;
+
+    if (size < 4U) {
+        return 0;
+    }
+
+    length = (int32_t)((size - 4U) / 2U);
+    length = (length > FUZZ_MAX_SAMPLES) ? FUZZ_MAX_SAMPLES : length;
+    if (length == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < length; i++) {
+        s_signal[i] = (int16_t)(uint16_t)((uint16_t)data[4 + (2 * i)] |
+                                          ((uint16_t)data[5 + (2 * i)] << 8));
+    }
+
+    /* Keep values within +/-16383 unless byte 0 asks for full scale, so
+     * both the unsaturated and the saturating ranges get exercised */
+    if (((data[0] & 0x80U) == 0U) || (FUZZ_FULL_SCALE == 0)) {
+        for (i = 0; i < length; i++) {
+            s_signal[i] = (int16_t)(s_signal[i] / 2);
+        }
+    }
+
+#if PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+    /* Q8.8 requires samples within -128..127 */
+    for (i = 0; i < length; i++) {
+        s_signal[i] = (int16_t)(s_signal[i] / 256);
+    }
+#endif
+
+    config.prominence_threshold_q16 = (int32_t)(((int32_t)data[1] * PEAK_Q_SAMPLE_ONE) / 4);
+    config.gradient_threshold_q16 = (int32_t)(((int32_t)data[2] * PEAK_Q_SAMPLE_ONE) / 16);
+    config.noise_floor_q16 = (int32_t)(((int32_t)data[3] - 128) * (PEAK_Q_SAMPLE_ONE * 4));
+
+    fuzz_one(length, ((int32_t)data[1] * length) / 256,
+             ((data[0] & 0x01U) != 0U) ? NULL : &config);
+
+    return 0;
+}
+
+#ifndef PEAK_FP_FUZZ_LIBFUZZER
+/*!
+ * @brief Standalone driver: random inputs from a fixed-seed PRNG.
+ *
+ * Mixes uniformly random bytes with structured inputs (ramps, plateaus,
+ * repeated values) so ties and long walks are exercised too.
+ */
+int main(int argc, char *argv[])
+{
+    static uint8_t input[4 + (FUZZ_MAX_SAMPLES * 2)];
+    long iterations = (argc > 1) ? strtol(argv[1], NULL, 10) : 20000L;
+    uint32_t state = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 10) : 0x12345678U;
+    long it;
+
+    state = (state == 0U) ? 1U : state;
+
+    for (it = 0; it < iterations; it++) {
+        uint32_t shape;
+        size_t samples;
+        size_t k;
+
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        shape = state % 4U;
+        /* Mostly short frames, occasionally up to FUZZ_MAX_SAMPLES */
+        samples = ((state >> 8) % 8U == 0U) ? (size_t)((state >> 12) % FUZZ_MAX_SAMPLES) :
+                                              (size_t)((state >> 12) % 600U);
+
+        for (k = 0; k < 4U + (samples * 2U); k++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            input[k] = (uint8_t)state;
+        }
+
+        /* Structured shapes: quantised values give ties and plateaus */
+        for (k = 0; k < samples; k++) {
+            int16_t v = (int16_t)(uint16_t)(input[4 + (2 * k)] | (input[5 + (2 * k)] << 8));
+
+            if (shape == 1U) {
+                v = (int16_t)((v % 8) * 100);
+            } else if (shape == 2U) {
+                v = (int16_t)(((int32_t)k * 7 % 500) + (v % 16));
+            } else if (shape == 3U) {
+                v = (int16_t)(v & (int16_t)0x7F00);
+            } else {
+                /* Uniform random */
+            }
+            input[4 + (2 * k)] = (uint8_t)((uint16_t)v & 0xFFU);
+            input[5 + (2 * k)] = (uint8_t)((uint16_t)v >> 8);
+        }
+
+        (void)LLVMFuzzerTestOneInput(input, 4U + (samples * 2U));
+    }
+
+    printf("fuzz-differential: %ld inputs, no divergence\n", iterations);
+
+    return 0;
+}
+#endif
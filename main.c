@@ -8,12 +8,25 @@
  * Simple test cases to validate fixed-point peak detection.
  */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
 #include "embedded-signal-peaks.h"
+#include "peak-telemetry.h"
+#include "signal-gen.h"
+#include "sample-ring.h"
+#include "peak-rate.h"
+#include "autocorr-period.h"
+#include "peak-tracker.h"
+#include "peak-coincidence.h"
 
 /* Test result tracking */
 static int tests_passed = 0;
@@ -31,6 +44,10 @@ static int tests_failed = 0;
         } \
     } while(0)
 
+/* Sample steps in the unit of get_peak_prominence_float() (full scale in
+ * Q1.15 builds, one sample step otherwise) */
+#define TEST_STEPS(n) ((float)(n) * (float)PEAK_Q_SAMPLE_ONE / (float)PEAK_Q_ONE)
+
 /*!
  * @brief Print signal for debugging
  */
@@ -137,7 +154,7 @@ static void test_matlab_prominence(void)
         printf("Expected: Peak at index 3, prominence ~20.0\n");
         
         TEST_ASSERT(peak_idx == 3, "Peak at correct index");
-        TEST_ASSERT(fabs(prominence - 20.0f) < 1.0f, 
+        TEST_ASSERT(fabs(prominence - TEST_STEPS(20)) < TEST_STEPS(1), 
                     "Prominence is MATLAB-compatible (~20, not ~15)");
     }
 }
@@ -154,15 +171,17 @@ static void test_noisy_signal(void)
     int32_t length = 100;
     int32_t peak_idx = -1;
     
-    /* Generate synthetic noisy signal */
-    for (int32_t i = 0; i < length; i++) {
-        /* Gaussian-like peak centered at 50 */
-        float x = (float)(i - 50) / 10.0f;
-        float base = 100.0f * expf(-x * x);
-        /* Add noise */
-        float noise = (float)((rand() % 21) - 10); /* ±10 */
-        signal[i] = (int16_t)(base + noise);
-    }
+    /* Gaussian peak centered at 50 plus noise (RMS 6) */
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    
+    gen_config.seed = 12345U;
+    gen_config.pulse_amplitude = 100;
+    gen_config.pulse_width = 10;
+    gen_config.pulse_first = 50;
+    gen_config.noise_rms = 6;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, signal, length);
     
     printf("Noisy signal: 100 samples, peak around index 50\n");
     
@@ -244,9 +263,9 @@ static void test_custom_config(void)
     
     /* Test with relaxed config */
     PeakConfigFP custom_config = {
-        .prominence_threshold_q16 = (int32_t)(0.1f * Q16_ONE), /* Lower threshold */
-        .gradient_threshold_q16 = (int32_t)(0.05f * Q16_ONE),
-        .noise_floor_q16 = (int32_t)(5.0f * Q16_ONE)
+        .prominence_threshold_q16 = PEAK_Q_SAMPLES(0.1f), /* Lower threshold */
+        .gradient_threshold_q16 = PEAK_Q_SAMPLES(0.05f),
+        .noise_floor_q16 = PEAK_Q_SAMPLES(5.0f)
     };
     
     PeakResultFP result2 = find_prominent_peak_fp(signal, length, &peak_idx, &custom_config);
@@ -266,29 +285,27 @@ static void test_adc_data(void)
 {
     printf("\n=== Test 7: Simulated ADC Data ===\n");
     
-    /* Simulate 12-bit ADC reading a sensor pulse */
+    /* Simulate a signed 8-bit ADC reading a sensor pulse */
     int16_t signal[128];
     int32_t length = 128;
     
-    /* Generate pulse + baseline + noise */
-    for (int32_t i = 0; i < length; i++) {
-        int16_t baseline = 512; /* 12-bit ADC midpoint */
-        int16_t noise = (int16_t)((rand() % 41) - 20); /* ±20 ADC counts */
-        
-        /* Pulse centered at sample 64 */
-        if (i >= 50 && i <= 78) {
-            float x = (float)(i - 64) / 8.0f;
-            int16_t pulse = (int16_t)(800.0f * expf(-x * x));
-            signal[i] = baseline + pulse + noise;
-        } else {
-            signal[i] = baseline + noise;
-        }
-    }
+    /* Pulse centered at sample 64 on a small offset, noise RMS 2 */
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    
+    gen_config.seed = 12345U;
+    gen_config.baseline = 10;
+    gen_config.pulse_amplitude = 100;
+    gen_config.pulse_width = 8;
+    gen_config.pulse_first = 64;
+    gen_config.noise_rms = 2;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, signal, length);
     
     int32_t peak_idx = -1;
     PeakResultFP result = find_prominent_peak_fp(signal, length, &peak_idx, NULL);
     
-    printf("ADC data: 128 samples, 12-bit resolution\n");
+    printf("ADC data: 128 samples, 8-bit resolution\n");
     printf("Result: %s, Peak index: %d\n", 
            (result == PEAK_FP_OK) ? "OK" : "FAILED", peak_idx);
     
@@ -303,6 +320,1622 @@ static void test_adc_data(void)
                 "ADC pulse detected");
 }
 
+/*!
+ * @brief Test 8: Lazy peak iterator
+ */
+static void test_lazy_iterator(void)
+{
+    printf("\n=== Test 8: Lazy Peak Iterator ===\n");
+    
+    /* Three peaks: 80 at index 3, 100 at index 7, 60 at index 11 */
+    int16_t signal[] = {10, 40, 70, 80, 60, 40, 70, 100, 50, 20, 40, 60, 30, 15};
+    int32_t length = 14;
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    int32_t count = 0;
+    int32_t best_idx = -1;
+    int32_t best_prominence = -1;
+    int32_t ref_idx = -1;
+    
+    print_signal("Signal", signal, length);
+    
+    /* Take only the first peak: scan must stop right after it */
+    PeakResultFP result = peak_iter_init(&iter, signal, length, NULL);
+    result = (result == PEAK_FP_OK) ? peak_iter_next(&iter, &peak) : result;
+    printf("First peak: index %d, prominence %.2f, scan stopped at %d\n",
+           peak.index, (float)peak.prominence_q16 / (float)PEAK_Q_SAMPLE_ONE, iter.position);
+    
+    TEST_ASSERT(result == PEAK_FP_OK && peak.index == 3,
+                "Iterator yields first peak in index order");
+    TEST_ASSERT(iter.position == 4 && iter.candidates == 1,
+                "Iterator stops scanning after consumer stops");
+    
+    /* Drain the rest and compare with the eager API */
+    peak_iter_init(&iter, signal, length, NULL);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        count++;
+        if (peak.prominence_q16 > best_prominence) {
+            best_prominence = peak.prominence_q16;
+            best_idx = peak.index;
+        }
+    }
+    find_prominent_peak_fp(signal, length, &ref_idx, NULL);
+    printf("Peaks yielded: %d, most prominent: %d (eager API: %d)\n",
+           count, best_idx, ref_idx);
+    
+    TEST_ASSERT(count == 3 && best_idx == ref_idx,
+                "Iterator agrees with find_prominent_peak_fp()");
+}
+
+/*!
+ * @brief Test 9: Fused smooth | detrend | peaks pipeline
+ */
+static void test_pipeline(void)
+{
+    printf("\n=== Test 9: Fused Preprocessing Pipeline ===\n");
+    
+    /* Broad pulse at 64 (height 100) plus a one-sample glitch at 20 (+110) */
+    int16_t signal[128];
+    int32_t length = 128;
+    int32_t raw_idx = -1;
+    int32_t fused_idx = -1;
+    int32_t passthrough_idx = -1;
+    
+    for (int32_t i = 0; i < length; i++) {
+        int32_t d = i - 64;
+        int32_t pulse = (d > -16 && d < 16) ? (100 - (d * d * 100) / 256) : 0;
+        signal[i] = (int16_t)(10 + pulse + ((i % 2 == 0) ? 3 : -3));
+    }
+    signal[20] += 110;
+    
+    PeakPipelineFP off = { .smooth_half_width = 0, .detrend_shift = 0 };
+    PeakPipelineFP smooth = { .smooth_half_width = 4, .detrend_shift = 6 };
+    
+    find_prominent_peak_fp(signal, length, &raw_idx, NULL);
+    find_prominent_peak_pipeline_fp(signal, length, &off, &passthrough_idx, NULL);
+    PeakResultFP result = find_prominent_peak_pipeline_fp(signal, length, &smooth,
+                                                           &fused_idx, NULL);
+    
+    printf("Raw: %d, pass-through pipeline: %d, smoothed+detrended: %d\n",
+           raw_idx, passthrough_idx, fused_idx);
+    
+    TEST_ASSERT(passthrough_idx == raw_idx,
+                "Disabled stages match find_prominent_peak_fp()");
+    TEST_ASSERT(result == PEAK_FP_OK && fused_idx >= 61 && fused_idx <= 67,
+                "Smoothing suppresses glitch, pulse selected");
+}
+
+/*!
+ * @brief Test 10: Streaming detector resumed block by block
+ */
+static void test_stream(void)
+{
+    printf("\n=== Test 10: Streaming Detector ===\n");
+    
+    /* Three frames of 32 samples, two triangle pulses per frame */
+    int16_t signal[96];
+    int16_t frame[32];
+    PeakStreamFP stream;
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    PeakInfoFP expected;
+    int32_t yielded = 0;
+    int32_t matched = 0;
+    int32_t frame_no = 0;
+    
+    for (int32_t i = 0; i < 96; i++) {
+        int32_t phase = i % 16;
+        signal[i] = (int16_t)(20 + ((phase < 8) ? (phase * 10) : ((16 - phase) * 10)));
+    }
+    
+    peak_stream_init(&stream, frame, 32, NULL);
+    peak_iter_init(&iter, signal, 32, NULL);
+    
+    /* Feed blocks of 7 samples; drain peaks after each block */
+    for (int32_t pos = 0; pos < 96; pos += 7) {
+        int32_t count = (96 - pos < 7) ? (96 - pos) : 7;
+        peak_stream_feed(&stream, &signal[pos], count);
+        
+        while (peak_stream_next(&stream, &peak) == PEAK_FP_OK) {
+            yielded++;
+            /* Reference: iterate the same frame directly */
+            while ((peak_iter_next(&iter, &expected) != PEAK_FP_OK) && (frame_no < 2)) {
+                frame_no++;
+                peak_iter_init(&iter, &signal[frame_no * 32], 32, NULL);
+            }
+            if ((expected.index + frame_no * 32 == peak.index) &&
+                (expected.prominence_q16 == peak.prominence_q16)) {
+                matched++;
+            }
+        }
+    }
+    
+    /* Resume as if 2^31 - 32 samples had passed: the second frame wraps */
+    int32_t wrapped[4];
+    int32_t num_wrapped = 0;
+    
+    peak_stream_init(&stream, frame, 32, NULL);
+    stream.frame_start = PEAK_STREAM_INDEX_MASK - 31U;
+    peak_stream_feed(&stream, signal, 64);
+    while ((num_wrapped < 4) && (peak_stream_next(&stream, &peak) == PEAK_FP_OK)) {
+        wrapped[num_wrapped] = peak.index;
+        num_wrapped++;
+    }
+    
+    printf("Peaks yielded: %d, matching per-frame scan: %d\n", yielded, matched);
+    printf("Indices across the 2^31 wrap: %d %d %d %d\n",
+           wrapped[0], wrapped[1], wrapped[2], wrapped[3]);
+    
+    TEST_ASSERT(yielded == 6 && matched == yielded,
+                "Stream yields per-frame peaks with stream indices");
+    TEST_ASSERT(num_wrapped == 4 && wrapped[0] == (INT32_MAX - 23) &&
+                wrapped[1] == (INT32_MAX - 7) && wrapped[2] == 8 && wrapped[3] == 24,
+                "Stream indices wrap modulo 2^31");
+}
+
+/*!
+ * @brief Test 11: Arena-backed peak lists for batch runs
+ */
+static void test_arena_batch(void)
+{
+    printf("\n=== Test 11: Arena Batch ===\n");
+    
+    int16_t frames[3][14] = {
+        {10, 40, 70, 80, 60, 40, 70, 100, 50, 20, 40, 60, 30, 15},
+        {10, 30, 50, 70, 90, 70, 50, 30, 10, 10, 10, 10, 10, 10},
+        {50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 50, 50}
+    };
+    int32_t expected[3] = {3, 1, 0};
+    uint64_t memory[16];  /* 128 bytes, reused for every frame */
+    PeakArenaFP arena;
+    PeakListFP list;
+    bool counts_ok = true;
+    bool exact_fit = true;
+    
+    peak_arena_init(&arena, memory, sizeof(memory));
+    
+    for (int32_t f = 0; f < 3; f++) {
+        peak_arena_reset(&arena);
+        find_peaks_arena_fp(frames[f], 14, NULL, &arena, &list);
+        printf("Frame %d: %d peaks, arena used %zu bytes\n", f, list.count, arena.used);
+        counts_ok = counts_ok && (list.count == expected[f]);
+        exact_fit = exact_fit && (arena.used == (size_t)list.count * sizeof(PeakInfoFP));
+    }
+    
+    /* An arena too small for all peaks reports it but keeps what fit */
+    peak_arena_init(&arena, memory, sizeof(PeakInfoFP) * 2U);
+    PeakResultFP result = find_peaks_arena_fp(frames[0], 14, NULL, &arena, &list);
+    
+    TEST_ASSERT(counts_ok, "Arena lists hold every peak per frame");
+    TEST_ASSERT(exact_fit, "Arena usage trimmed to result size");
+    TEST_ASSERT(result == PEAK_FP_BUFFER_TOO_SMALL && list.count == 2,
+                "Exhausted arena reported, partial list kept");
+}
+
+/*!
+ * @brief Test 12: Instrumentation counters (PEAK_FP_ENABLE_STATS builds)
+ */
+static void test_stats(void)
+{
+    printf("\n=== Test 12: Instrumentation Counters ===\n");
+    
+#ifdef PEAK_FP_ENABLE_STATS
+    /* 40 equal-height peaks, more than MAX_PEAKS (32): all are candidates */
+    int16_t signal[122];
+    int32_t peak_idx = -1;
+    PeakStatsFP stats;
+    
+    for (int32_t i = 0; i < 122; i++) {
+        signal[i] = (int16_t)(100 + (i % 3) * 20);
+    }
+    
+    find_prominent_peak_fp(signal, 122, &peak_idx, NULL);
+    peak_fp_get_stats(&stats);
+    
+    printf("Candidates: %d found; walk steps: %d left, %d right\n",
+           stats.candidates_found, stats.walk_steps_left, stats.walk_steps_right);
+    printf("Cycles: convert %u, candidates %u, prominence %u\n",
+           stats.cycles_convert, stats.cycles_candidates, stats.cycles_prominence);
+    
+    TEST_ASSERT(stats.candidates_found == 40, "All candidates kept");
+    TEST_ASSERT(stats.walk_steps_left == 2 * 40 && stats.walk_steps_right == 2 * 40,
+                "Contour walk steps counted");
+#else
+    printf("Skipped: build with -DPEAK_FP_ENABLE_STATS\n");
+#endif
+}
+
+/*!
+ * @brief Test 13: Telemetry page counters and latency histogram
+ */
+static void test_telemetry(void)
+{
+    printf("\n=== Test 13: Telemetry Stats Page ===\n");
+    
+    /* Process-local page; detectors normally use peak_telemetry_open() */
+    static PeakTelemetryPage page;
+    PeakTelemetrySnapshot snap;
+    int16_t signal[] = {10, 40, 70, 80, 60, 40, 70, 100, 50, 20};
+    int32_t peak_idx = -1;
+    bool buckets_ok = true;
+    
+    peak_telemetry_init(&page);
+    PeakTelemetrySlot *slot_a = peak_telemetry_claim_slot(&page);
+    PeakTelemetrySlot *slot_b = peak_telemetry_claim_slot(&page);
+    
+    /* 90 fast frames on one thread, 10 slow frames (one rejected) and 5 skips on another */
+    for (int32_t i = 0; i < 90; i++) {
+        peak_telemetry_record(slot_a, PEAK_FP_OK, 1000U);
+    }
+    for (int32_t i = 0; i < 10; i++) {
+        peak_telemetry_record(slot_b, (i == 0) ? PEAK_FP_INVALID_INPUT : PEAK_FP_NO_PEAK_FOUND,
+                              50000U);
+    }
+    for (int32_t i = 0; i < 5; i++) {
+        peak_telemetry_record_skip(slot_b);
+    }
+    peak_telemetry_detect(slot_a, signal, 10, &peak_idx, NULL);
+    peak_telemetry_detect(slot_a, signal, 0, &peak_idx, NULL);
+    
+    peak_telemetry_snapshot(&page, &snap);
+    uint64_t p50 = peak_telemetry_percentile(snap.latency_hist, 500U);
+    uint64_t p99 = peak_telemetry_percentile(snap.latency_hist, 990U);
+    
+    printf("Frames: %llu (with peak %llu), skipped %llu, rejected %llu\n",
+           (unsigned long long)snap.frames, (unsigned long long)snap.frames_with_peak,
+           (unsigned long long)snap.frames_skipped,
+           (unsigned long long)snap.frames_rejected);
+    printf("Latency p50 >= %llu ns, p99 >= %llu ns\n",
+           (unsigned long long)p50, (unsigned long long)p99);
+    
+    /* Every value lands in a bucket whose floor is within 25% below it */
+    for (uint64_t v = 1U; v < 100000000U; v = (v * 3U) / 2U + 1U) {
+        uint64_t floor_ns = peak_telemetry_bucket_floor(peak_telemetry_bucket(v));
+        buckets_ok = buckets_ok && (floor_ns <= v) && ((v - floor_ns) * 4U <= v);
+    }
+    
+    TEST_ASSERT(slot_a != NULL && slot_b != NULL && slot_a != slot_b,
+                "Each writer gets its own slot");
+    TEST_ASSERT(snap.frames == 102 && snap.frames_with_peak == 91 &&
+                snap.frames_skipped == 5 && snap.frames_rejected == 2,
+                "Counters aggregated across slots");
+    TEST_ASSERT(p50 <= 1000U && p50 * 4U > 3000U && p99 <= 50000U && p99 * 4U > 150000U,
+                "Latency percentiles from histogram");
+    TEST_ASSERT(buckets_ok, "Histogram buckets within 25% relative width");
+    
+    /* A second writer process attaches to the shared page without wiping it */
+    PeakTelemetryPage *writer_a;
+    PeakTelemetryPage *writer_b;
+    PeakTelemetryPage *reader;
+    PeakTelemetrySnapshot shared = { 0 };
+    
+    (void)shm_unlink("/peaks_selftest");
+    writer_a = peak_telemetry_open("/peaks_selftest", true);
+    if (writer_a != NULL) {
+        peak_telemetry_record(peak_telemetry_claim_slot(writer_a), PEAK_FP_OK, 1000U);
+    }
+    writer_b = peak_telemetry_open("/peaks_selftest", true);
+    if (writer_b != NULL) {
+        peak_telemetry_record(peak_telemetry_claim_slot(writer_b), PEAK_FP_OK, 1000U);
+    }
+    reader = peak_telemetry_open("/peaks_selftest", false);
+    peak_telemetry_snapshot(reader, &shared);
+    printf("Shared page: %llu frames from %u writers\n", (unsigned long long)shared.frames,
+           (reader != NULL) ? atomic_load(&reader->slots_claimed) : 0U);
+    TEST_ASSERT(writer_a != NULL && writer_b != NULL && reader != NULL &&
+                shared.frames == 2 && atomic_load(&reader->slots_claimed) == 2U,
+                "Second writer attaches to a live page without resetting it");
+    peak_telemetry_close(reader);
+    peak_telemetry_close(writer_b);
+    peak_telemetry_close(writer_a);
+    (void)shm_unlink("/peaks_selftest");
+}
+
+/*!
+ * @brief Test 14: Deterministic signal generator
+ */
+static void test_signal_gen(void)
+{
+    printf("\n=== Test 14: Signal Generator ===\n");
+    
+    /* ECG-like train: 250 Hz, ~75 bpm with jitter, drift, noise at 30 dB SNR */
+    SignalGenConfig config = { 0 };
+    SignalGen gen_a;
+    SignalGen gen_b;
+    static int16_t whole[4000];
+    static int16_t split[4000];
+    int32_t pos = 0;
+    int32_t block = 1;
+    bool same = true;
+    int32_t r_peaks = 0;
+    int64_t sum = 0;
+    int64_t sum_sq = 0;
+    
+    config.seed = 2025U;
+    config.baseline = -60;
+    config.drift_q16 = Q16_ONE / 100;
+    config.wander_amplitude = 8;
+    config.wander_step = 0x00400000U;
+    config.pulse_shape = SIGNAL_PULSE_QRS;
+    config.pulse_amplitude = 100;
+    config.pulse_amplitude_spread = 10;
+    config.pulse_width = 3;
+    config.pulse_first = 100;
+    config.pulse_period = 190;
+    config.pulse_jitter = 20;
+    config.noise_rms = signal_noise_rms_for_snr(100, 30);
+    
+    signal_gen_init(&gen_a, &config);
+    signal_gen_block(&gen_a, whole, 4000);
+    
+    /* Same stream generated in blocks of 1, 2, 3, ... samples */
+    signal_gen_init(&gen_b, &config);
+    while (pos < 4000) {
+        int32_t n = ((4000 - pos) < block) ? (4000 - pos) : block;
+        signal_gen_block(&gen_b, &split[pos], n);
+        pos += n;
+        block++;
+    }
+    
+    for (int32_t i = 0; i < 4000; i++) {
+        same = same && (whole[i] == split[i]);
+    }
+    
+    /* One R wave per ~200 samples; T waves stay below 70 */
+    PeakConfigFP peak_config = { PEAK_Q_SAMPLES(70), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    
+    (void)peak_iter_init(&iter, whole, 4000, &peak_config);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        r_peaks++;
+    }
+    
+    /* Noise statistics of a noise-only stream */
+    SignalGenConfig noise_config = { 0 };
+    noise_config.seed = 7U;
+    noise_config.noise_rms = 50;
+    signal_gen_init(&gen_a, &noise_config);
+    signal_gen_block(&gen_a, whole, 4000);
+    for (int32_t i = 0; i < 4000; i++) {
+        sum += whole[i];
+        sum_sq += (int64_t)whole[i] * whole[i];
+    }
+    
+    printf("Split-block stream identical: %s, R waves: %d\n", same ? "yes" : "no", r_peaks);
+    printf("Noise RMS for 30 dB: %d, measured noise var: %lld\n",
+           config.noise_rms, (long long)(sum_sq / 4000));
+    
+    TEST_ASSERT(same, "Block size does not change the stream");
+    TEST_ASSERT(r_peaks >= 18 && r_peaks <= 21, "One R wave per beat");
+    TEST_ASSERT(config.noise_rms == 3, "SNR maps to noise RMS");
+    TEST_ASSERT(sum / 4000 > -5 && sum / 4000 < 5 &&
+                sum_sq / 4000 > 2250 && sum_sq / 4000 < 2750,
+                "Noise mean and variance");
+    TEST_ASSERT(signal_sine_q15(0x40000000U) == SIGNAL_Q15_ONE &&
+                signal_sine_q15(0xC0000000U) == -SIGNAL_Q15_ONE &&
+                signal_gauss_q15(0, 5) == SIGNAL_Q15_ONE,
+                "Waveform tables");
+}
+
+/* Ring stress test: producer thread state */
+#define RING_STRESS_SAMPLES (200000)
+#define RING_STRESS_FRAME (256)
+#define RING_STRESS_MAX_PEAKS (4000)
+
+static int16_t s_ring_source[RING_STRESS_SAMPLES];
+static atomic_bool s_ring_producer_done;
+
+static void *ring_producer(void *arg)
+{
+    SampleRing *ring = (SampleRing *)arg;
+    int32_t pos = 0;
+    int32_t block = 1;
+    
+    /* ISR-like pushes of 1..97 samples, spinning while the ring is full */
+    while (pos < RING_STRESS_SAMPLES) {
+        int32_t n = ((RING_STRESS_SAMPLES - pos) < block) ? (RING_STRESS_SAMPLES - pos) : block;
+        uint32_t pushed = sample_ring_push(ring, &s_ring_source[pos], (uint32_t)n);
+        
+        pos += (int32_t)pushed;
+        if (pushed == 0U) {
+            (void)sched_yield();
+        }
+        block = (block % 97) + 1;
+    }
+    
+    atomic_store(&s_ring_producer_done, true);
+    
+    return NULL;
+}
+
+/*!
+ * @brief Run producer and streaming consumer on separate threads.
+ *
+ * @return Number of mismatches against single-threaded framing (-1 on error)
+ */
+static int32_t run_ring_stress(uint32_t capacity, const PeakConfigFP *config,
+                               const PeakInfoFP expected[], int32_t num_expected)
+{
+    static int16_t storage[1024];
+    static int16_t frame[RING_STRESS_FRAME];
+    SampleRing ring;
+    PeakStreamFP stream;
+    PeakInfoFP peak;
+    pthread_t producer;
+    int32_t count = 0;
+    int32_t mismatches = 0;
+    
+    if ((sample_ring_init(&ring, storage, capacity) != PEAK_FP_OK) ||
+        (peak_stream_init(&stream, frame, RING_STRESS_FRAME, config) != PEAK_FP_OK)) {
+        return -1;
+    }
+    
+    atomic_store(&s_ring_producer_done, false);
+    if (pthread_create(&producer, NULL, ring_producer, &ring) != 0) {
+        return -1;
+    }
+    
+    for (;;) {
+        bool done = atomic_load(&s_ring_producer_done);
+        
+        if (sample_ring_stream_next(&ring, &stream, &peak) == PEAK_FP_OK) {
+            if ((count >= num_expected) || (peak.index != expected[count].index) ||
+                (peak.prominence_q16 != expected[count].prominence_q16)) {
+                mismatches++;
+            }
+            count++;
+        } else if (done) {
+            break;
+        } else {
+            (void)sched_yield();
+        }
+    }
+    
+    (void)pthread_join(producer, NULL);
+    
+    return mismatches + ((count > num_expected) ? (count - num_expected) : (num_expected - count));
+}
+
+/*!
+ * @brief Test 15: Lock-free SPSC ring feeding the streaming detector
+ */
+static void test_sample_ring(void)
+{
+    printf("\n=== Test 15: SPSC Sample Ring ===\n");
+    
+    static PeakInfoFP expected[RING_STRESS_MAX_PEAKS];
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    PeakConfigFP config = { PEAK_Q_SAMPLES(30), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    int32_t num_expected = 0;
+    
+    gen_config.seed = 61U;
+    gen_config.baseline = 20;
+    gen_config.pulse_amplitude = 60;
+    gen_config.pulse_amplitude_spread = 40;
+    gen_config.pulse_width = 5;
+    gen_config.pulse_first = 40;
+    gen_config.pulse_period = 90;
+    gen_config.pulse_jitter = 30;
+    gen_config.noise_rms = 1;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, s_ring_source, RING_STRESS_SAMPLES);
+    
+    /* Reference: consecutive complete frames, scanned single-threaded */
+    for (int32_t start = 0; (start + RING_STRESS_FRAME) <= RING_STRESS_SAMPLES;
+         start += RING_STRESS_FRAME) {
+        PeakIteratorFP iter;
+        PeakInfoFP peak;
+        
+        (void)peak_iter_init(&iter, &s_ring_source[start], RING_STRESS_FRAME, &config);
+        while ((peak_iter_next(&iter, &peak) == PEAK_FP_OK) &&
+               (num_expected < RING_STRESS_MAX_PEAKS)) {
+            peak.index += start;
+            expected[num_expected] = peak;
+            num_expected++;
+        }
+    }
+    /* Capacity multiple of the frame: frames are scanned in ring storage */
+    int32_t aligned = run_ring_stress(1024U, &config, expected, num_expected);
+    /* Odd capacity: frames cut by the wrap go through the frame buffer */
+    int32_t odd = run_ring_stress(1000U, &config, expected, num_expected);
+    
+    printf("Reference peaks: %d, mismatches aligned: %d, odd capacity: %d\n",
+           num_expected, aligned, odd);
+    
+    TEST_ASSERT(num_expected > 1000 && aligned == 0,
+                "Ring stream matches single-threaded framing");
+    TEST_ASSERT(odd == 0, "Frames straddling the wrap are reassembled");
+}
+
+/*!
+ * @brief Test 16: Two-span input across a ring wrap
+ */
+static void test_two_spans(void)
+{
+    printf("\n=== Test 16: Two-Span Input ===\n");
+    
+    /* Peak 106 at index 33 with a shoulder at 20 and a small peak at 50 */
+    int16_t signal[64];
+    int32_t reference = -1;
+    bool all_splits_match = true;
+    
+    for (int32_t i = 0; i < 64; i++) {
+        int32_t d = (i < 33) ? (33 - i) : (i - 33);
+        signal[i] = (int16_t)(10 + ((d < 12) ? (96 - (d * 8)) : 0) +
+                              ((i == 20) ? 4 : 0) + ((i == 50) ? 18 : 0));
+    }
+    (void)find_prominent_peak_fp(signal, 64, &reference, NULL);
+    
+    /* Every seam position, including empty head or tail */
+    for (int32_t k = 0; k <= 64; k++) {
+        int32_t idx = -1;
+        PeakResultFP result = find_prominent_peak_fp_spans(signal, k, &signal[k], 64 - k,
+                                                           &idx, NULL);
+        all_splits_match = all_splits_match && (result == PEAK_FP_OK) && (idx == reference);
+    }
+    
+    /* Last 64 samples of a wrapped ring, analysed without linearising */
+    static int16_t storage[100];
+    SampleRing ring;
+    const int16_t *head;
+    const int16_t *tail;
+    int32_t head_len = 0;
+    int32_t tail_len = 0;
+    int32_t ring_idx = -1;
+    
+    (void)sample_ring_init(&ring, storage, 100);
+    (void)sample_ring_push(&ring, signal, 60);           /* Filler */
+    sample_ring_release(&ring, 60);
+    (void)sample_ring_push(&ring, signal, 64);           /* Wraps at 100 */
+    PeakResultFP peek = sample_ring_peek_last(&ring, 64, &head, &head_len, &tail, &tail_len);
+    PeakResultFP ring_result = find_prominent_peak_fp_spans(head, head_len, tail, tail_len,
+                                                            &ring_idx, NULL);
+    
+    printf("Reference index: %d, ring spans %d + %d, ring index: %d\n",
+           reference, head_len, tail_len, ring_idx);
+    
+    TEST_ASSERT(reference == 33 && all_splits_match, "Every seam position matches linear input");
+    TEST_ASSERT(peek == PEAK_FP_OK && head_len == 40 && tail_len == 24 &&
+                ring_result == PEAK_FP_OK && ring_idx == reference,
+                "Wrapped ring window analysed in place");
+}
+
+/*!
+ * @brief Test 17: Circular (periodic) frames
+ */
+static void test_circular(void)
+{
+    printf("\n=== Test 17: Circular Frames ===\n");
+    
+    /* One revolution: main lobe straddles the seam (top at index 0),
+     * a smaller lobe of 50 sits mid-frame */
+    int16_t signal[24] = {
+        80, 60, 30, 10, 10, 10, 10, 10, 20, 35, 50, 35,
+        20, 10, 10, 10, 10, 10, 10, 10, 10, 30, 55, 70
+    };
+    int16_t rotated[24];
+    int32_t linear_idx = -1;
+    int32_t circular_idx = -1;
+    bool rotation_ok = true;
+    
+    (void)find_prominent_peak_fp(signal, 24, &linear_idx, NULL);
+    PeakResultFP result = find_prominent_peak_fp_circular(signal, 24, &circular_idx, NULL);
+    
+    /* The answer must follow any rotation of the frame */
+    for (int32_t r = 1; r < 24; r++) {
+        int32_t idx = -1;
+        
+        for (int32_t i = 0; i < 24; i++) {
+            rotated[(i + r) % 24] = signal[i];
+        }
+        rotation_ok = rotation_ok &&
+                      (find_prominent_peak_fp_circular(rotated, 24, &idx, NULL) == PEAK_FP_OK) &&
+                      (idx == r);
+    }
+    
+    printf("Linear index: %d, circular index: %d\n", linear_idx, circular_idx);
+    
+    TEST_ASSERT(linear_idx == 10, "Linear mode misses the lobe on the seam");
+    TEST_ASSERT(result == PEAK_FP_OK && circular_idx == 0, "Circular mode finds peak at index 0");
+    TEST_ASSERT(rotation_ok, "Circular result follows frame rotation");
+}
+
+/* Simulated DMA: 2 x 128-sample halves */
+#define DMA_HALF (128)
+#define DMA_TOTAL (DMA_HALF * 2 * 16)
+
+static int16_t s_dma_buffer[DMA_HALF * 2];
+static PeakStackEntryFP s_pp_stack[DMA_HALF * 4];
+static PeakPingPongFP s_pp;
+static PeakInfoFP s_pp_found[128];
+static int32_t s_pp_found_count;
+static int32_t s_pp_processed;
+static int32_t s_pp_max_latency;
+
+/* Half/full-transfer callback body */
+static void dma_half_complete(const int16_t *half)
+{
+    PeakInfoFP peaks[16];
+    int32_t n = 0;
+    
+    (void)peak_pingpong_process(&s_pp, half, DMA_HALF, peaks, 16, &n);
+    s_pp_processed += DMA_HALF;
+    
+    for (int32_t k = 0; (k < n) && (s_pp_found_count < 128); k++) {
+        int32_t latency = (s_pp_processed - 1) - peaks[k].index;
+        s_pp_max_latency = (latency > s_pp_max_latency) ? latency : s_pp_max_latency;
+        s_pp_found[s_pp_found_count] = peaks[k];
+        s_pp_found_count++;
+    }
+}
+
+/*!
+ * @brief Test 18: Ping-pong DMA with peaks on the half boundaries
+ */
+static void test_pingpong_dma(void)
+{
+    printf("\n=== Test 18: Ping-Pong DMA ===\n");
+    
+    static int16_t source[DMA_TOTAL];
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    PeakConfigFP config = { PEAK_Q_SAMPLES(30), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    int32_t per_half_hits = 0;
+    bool unique = true;
+    bool match = true;
+    int32_t expected = 0;
+    
+    /* Every pulse is centred exactly on a half/full boundary; with this seed
+     * the edge of the pulse after the stream rises above the last one */
+    gen_config.seed = 66U;
+    gen_config.baseline = 10;
+    gen_config.pulse_amplitude = 80;
+    gen_config.pulse_amplitude_spread = 30;
+    gen_config.pulse_width = 4;
+    gen_config.pulse_first = DMA_HALF;
+    gen_config.pulse_period = DMA_HALF;
+    gen_config.noise_rms = 1;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, source, DMA_TOTAL);
+    
+    (void)peak_pingpong_init(&s_pp, s_pp_stack, DMA_HALF * 4, DMA_HALF, &config);
+    s_pp_found_count = 0;
+    s_pp_processed = 0;
+    s_pp_max_latency = 0;
+    
+    /* DMA driver: one sample per tick, HT/TC interrupts at the half ends */
+    for (int32_t t = 0; t < DMA_TOTAL; t++) {
+        int32_t slot = t % (DMA_HALF * 2);
+        
+        s_dma_buffer[slot] = source[t];
+        if (slot == (DMA_HALF - 1)) {
+            dma_half_complete(&s_dma_buffer[0]);
+        } else if (slot == ((DMA_HALF * 2) - 1)) {
+            dma_half_complete(&s_dma_buffer[DMA_HALF]);
+        } else {
+            /* Transfer in progress */
+        }
+    }
+    
+    /* Old approach: each half on its own */
+    for (int32_t h = 0; h < (DMA_TOTAL / DMA_HALF); h++) {
+        int32_t idx = -1;
+        if ((find_prominent_peak_fp(&source[h * DMA_HALF], DMA_HALF, &idx, &config) == PEAK_FP_OK) &&
+            (idx >= 1) && (idx < (DMA_HALF - 1))) {
+            per_half_hits++;
+        }
+    }
+    
+    /* Whole-stream reference */
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    (void)peak_iter_init(&iter, source, DMA_TOTAL, &config);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        bool found = false;
+        for (int32_t k = 0; k < s_pp_found_count; k++) {
+            found = found || (s_pp_found[k].index == peak.index);
+        }
+        match = match && found;
+        expected++;
+    }
+    for (int32_t a = 0; a < s_pp_found_count; a++) {
+        for (int32_t b = a + 1; b < s_pp_found_count; b++) {
+            unique = unique && (s_pp_found[a].index != s_pp_found[b].index);
+        }
+    }
+    
+    printf("Boundary pulses: %d, ping-pong peaks: %d, per-half frames: %d, max latency: %d\n",
+           expected, s_pp_found_count, per_half_hits, s_pp_max_latency);
+    
+    TEST_ASSERT(expected == (DMA_TOTAL / DMA_HALF) - 1 && match &&
+                s_pp_found_count == expected && unique,
+                "Each boundary peak reported exactly once");
+    TEST_ASSERT(s_pp_max_latency < (2 * DMA_HALF), "Latency bounded by the half size");
+    
+    /* Falling ramp with spikes: the 16-entry stack stays full and drops
+     * its oldest entry on almost every sample */
+    static int16_t ramp[240];
+    static PeakStackEntryFP small_stack[16];
+    PeakInfoFP ramp_peaks[32];
+    PeakConfigFP ramp_config = { PEAK_Q_SAMPLES(2), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    int32_t ramp_found = 0;
+    int32_t ramp_expected = 0;
+    int32_t got = 0;
+    bool ramp_match = true;
+    
+    for (int32_t i = 0; i < 240; i++) {
+        ramp[i] = (int16_t)((120 - i) + (((i % 20) == 10) ? 4 : 0));
+    }
+    (void)peak_pingpong_init(&s_pp, small_stack, 16, 8, &ramp_config);
+    (void)peak_pingpong_process(&s_pp, ramp, 240, ramp_peaks, 32, &got);
+    ramp_found = got;
+    (void)peak_pingpong_flush(&s_pp, &ramp_peaks[ramp_found], 32 - ramp_found, &got);
+    ramp_found += got;
+    (void)peak_iter_init(&iter, ramp, 240, &ramp_config);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        ramp_match = ramp_match && (ramp_expected < ramp_found) &&
+                     (ramp_peaks[ramp_expected].index == peak.index) &&
+                     (ramp_peaks[ramp_expected].prominence_q16 == peak.prominence_q16);
+        ramp_expected++;
+    }
+    printf("Falling ramp through a full stack: %d of %d peaks\n", ramp_found, ramp_expected);
+    TEST_ASSERT(ramp_expected > 4 && ramp_found == ramp_expected && ramp_match,
+                "Full stack drops its oldest entry without losing peaks");
+}
+
+#define SLIDE_WINDOW (512)
+#define SLIDE_HOP (64)
+#define SLIDE_TOTAL (SLIDE_WINDOW * 8)
+
+static peak_q_t s_slide_samples[2 * SLIDE_WINDOW];
+static PeakSlideBlockFP s_slide_blocks[SLIDE_WINDOW / SLIDE_HOP];
+static PeakSlideCandidateFP s_slide_cands[PEAK_SLIDE_CANDIDATES(SLIDE_WINDOW)];
+
+/*!
+ * @brief Test 19: Hop-overlapped windows match full re-detection
+ */
+static void test_sliding_window(void)
+{
+    printf("\n=== Test 19: Sliding Window ===\n");
+    
+    static int16_t source[SLIDE_TOTAL];
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    PeakSlideFP slide;
+    PeakConfigFP config = { PEAK_Q_SAMPLES(200), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    int32_t windows = 0;
+    int32_t mismatches = 0;
+    PeakResultFP init_result;
+    
+    gen_config.seed = 65U;
+    gen_config.baseline = 200;
+    gen_config.wander_amplitude = 80;
+    gen_config.wander_step = 0x00400000U;
+    gen_config.pulse_shape = SIGNAL_PULSE_QRS;
+    gen_config.pulse_amplitude = 1200;
+    gen_config.pulse_amplitude_spread = 400;
+    gen_config.pulse_width = 5;
+    gen_config.pulse_first = 40;
+    gen_config.pulse_period = 180;
+    gen_config.pulse_jitter = 60;
+    gen_config.noise_rms = 12;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, source, SLIDE_TOTAL);
+    
+    init_result = peak_slide_init(&slide, s_slide_samples, s_slide_blocks, s_slide_cands,
+                                  SLIDE_WINDOW, SLIDE_HOP, &config);
+    
+    for (int32_t pos = 0; pos < SLIDE_TOTAL; pos += SLIDE_HOP) {
+        int32_t idx = -1;
+        int32_t ref_idx = -1;
+        int32_t first = pos + SLIDE_HOP - SLIDE_WINDOW;
+        PeakResultFP result = peak_slide_push(&slide, &source[pos], &idx);
+    
+        if (first < 0) {
+            mismatches += (result != PEAK_FP_BUFFER_TOO_SMALL) ? 1 : 0;
+            continue;
+        }
+    
+        PeakResultFP ref = find_prominent_peak_fp(&source[first], SLIDE_WINDOW, &ref_idx, &config);
+        if ((result != ref) || ((ref == PEAK_FP_OK) && (idx != (first + ref_idx)))) {
+            mismatches++;
+        }
+        windows++;
+    }
+    
+    printf("Windows: %d (window %d, hop %d), mismatches: %d\n",
+           windows, SLIDE_WINDOW, SLIDE_HOP, mismatches);
+    
+    TEST_ASSERT(init_result == PEAK_FP_OK, "Sliding detector initialised");
+    TEST_ASSERT(windows == ((SLIDE_TOTAL - SLIDE_WINDOW) / SLIDE_HOP) + 1 && mismatches == 0,
+                "Every hop matches re-detection of the window");
+    
+#ifdef PEAK_FP_ENABLE_STATS
+    /* Zigzag on a slow ramp: about window / 3 candidates stay live and
+       many share the top prominence, so revisiting each of them would
+       cost O(window) per hop */
+    PeakConfigFP zigzag_config = { PEAK_Q_SAMPLES(1), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    int32_t max_walked = 0;
+    int32_t max_steps = 0;
+    
+    for (int32_t i = 0; i < SLIDE_TOTAL; i++) {
+        source[i] = (int16_t)(((i % SLIDE_WINDOW) / 8) + (((i % 3) == 1) ? 3 : 0));
+    }
+    (void)peak_slide_init(&slide, s_slide_samples, s_slide_blocks, s_slide_cands,
+                          SLIDE_WINDOW, SLIDE_HOP, &zigzag_config);
+    mismatches = 0;
+    
+    for (int32_t pos = 0; pos < SLIDE_TOTAL; pos += SLIDE_HOP) {
+        int32_t idx = -1;
+        int32_t ref_idx = -1;
+        int32_t first = pos + SLIDE_HOP - SLIDE_WINDOW;
+        PeakResultFP result = peak_slide_push(&slide, &source[pos], &idx);
+        PeakStatsFP stats;
+    
+        peak_fp_get_stats(&stats);
+        if (first <= 0) {
+            continue;  /* The first window walks every candidate once */
+        }
+        max_walked = (stats.candidates_found > max_walked) ? stats.candidates_found : max_walked;
+        if ((stats.walk_steps_left + stats.walk_steps_right) > max_steps) {
+            max_steps = stats.walk_steps_left + stats.walk_steps_right;
+        }
+    
+        PeakResultFP ref = find_prominent_peak_fp(&source[first], SLIDE_WINDOW, &ref_idx,
+                                                  &zigzag_config);
+        if ((result != ref) || ((ref == PEAK_FP_OK) && (idx != (first + ref_idx)))) {
+            mismatches++;
+        }
+    }
+    
+    printf("Zigzag: at most %d candidates walked and %d walk steps per hop, mismatches: %d\n",
+           max_walked, max_steps, mismatches);
+    TEST_ASSERT(mismatches == 0 && max_walked <= (SLIDE_HOP / 2) &&
+                max_steps <= (4 * ((2 * SLIDE_HOP) + (SLIDE_WINDOW / SLIDE_HOP))),
+                "A hop walks only new and invalidated candidates");
+#endif
+}
+
+/*!
+ * @brief Test 20: Region-of-interest gates and exclusion zones
+ */
+static void test_roi_mask(void)
+{
+    printf("\n=== Test 20: Region-of-Interest Masks ===\n");
+    
+    int16_t signal[400];
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    PeakConfigFP config = { PEAK_Q_SAMPLES(10), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    PeakIntervalFP transient_zone[1] = { { 140, 170 } };
+    PeakIntervalFP gates[2] = { { 50, 110 }, { 290, 350 } };
+    uint32_t bitmap[(400 + 31) / 32] = { 0U };
+    PeakRoiFP exclude = { PEAK_ROI_EXCLUDE, transient_zone, 1, NULL };
+    PeakRoiFP include = { PEAK_ROI_INCLUDE, gates, 2, NULL };
+    PeakRoiFP exclude_bits = { PEAK_ROI_EXCLUDE, NULL, 0, bitmap };
+    int32_t plain_idx = -1;
+    int32_t exclude_idx = -1;
+    int32_t include_idx = -1;
+    int32_t bits_idx = -1;
+    int32_t gate_ref = -1;
+    
+    /* Pulses at 80, 200 and 320 on a clean baseline */
+    gen_config.seed = 67U;
+    gen_config.baseline = 10;
+    gen_config.pulse_amplitude = 50;
+    gen_config.pulse_width = 6;
+    gen_config.pulse_first = 80;
+    gen_config.pulse_period = 120;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, signal, 400);
+    signal[200] += 10;
+    
+    /* Switching transient far above any pulse */
+    for (int32_t i = 150; i < 160; i++) {
+        signal[i] = (int16_t)(((i & 1) != 0) ? 120 : -120);
+    }
+    for (int32_t i = 140; i < 170; i++) {
+        bitmap[i / 32] |= 1UL << (i % 32);
+    }
+    
+    (void)find_prominent_peak_fp(signal, 400, &plain_idx, &config);
+    (void)find_prominent_peak_fp_roi(signal, 400, &exclude, &exclude_idx, &config);
+    (void)find_prominent_peak_fp_roi(signal, 400, &include, &include_idx, &config);
+    (void)find_prominent_peak_fp_roi(signal, 400, &exclude_bits, &bits_idx, &config);
+    (void)find_prominent_peak_fp(&signal[50], 60, &gate_ref, &config);
+    
+    printf("Plain: %d, transient excluded: %d (bitmap %d), gated: %d\n",
+           plain_idx, exclude_idx, bits_idx, include_idx);
+    
+    TEST_ASSERT(plain_idx >= 150 && plain_idx < 160, "Unmasked scan locks onto the transient");
+    TEST_ASSERT(exclude_idx >= 195 && exclude_idx <= 205 && bits_idx == exclude_idx,
+                "Exclusion zone skips the transient (intervals and bitmap agree)");
+    TEST_ASSERT(include_idx >= 75 && include_idx <= 85 && include_idx == (50 + gate_ref),
+                "Gates confine the search");
+}
+
+/*!
+ * @brief Test 21: Streaming heart-rate estimate with outliers
+ */
+static void test_peak_rate(void)
+{
+    printf("\n=== Test 21: Peak Rate Estimation ===\n");
+    
+    PeakRateConfigFP rate_config = { 9, 60 * 250, Q16_ONE / 4, 3 };  /* BPM at 250 Hz */
+    PeakRateEstimatorFP est;
+    PeakRateFP rate;
+    SignalRng rng;
+    int32_t window[9];
+    int32_t filled = 0;
+    int32_t index = 1000;
+    int32_t median_errors = 0;
+    int32_t outliers_flagged = 0;
+    int32_t outliers_injected = 0;
+    int32_t false_alarms = 0;
+    PeakResultFP first;
+    PeakResultFP gap;
+    PeakResultFP after_gap;
+    int32_t median_before_gap;
+    
+    signal_rng_seed(&rng, 68U, 1U);
+    (void)peak_rate_init(&est, &rate_config);
+    first = peak_rate_push(&est, index, &rate);
+    
+    for (int32_t beat = 0; beat < 400; beat++) {
+        /* ~75 BPM with jitter; every 37th beat missed, every 53rd spurious */
+        int32_t interval = 195 + (int32_t)signal_rng_below(&rng, 11U);
+        bool injected = false;
+        
+        if ((beat % 37) == 36) {
+            interval *= 2;
+            injected = true;
+        } else if ((beat % 53) == 52) {
+            interval /= 2;
+            injected = true;
+        } else {
+            /* Normal beat */
+        }
+        
+        index += interval;
+        (void)peak_rate_push(&est, index, &rate);
+        
+        /* Brute-force median of the last 9 intervals */
+        int32_t sorted[9];
+        int32_t n;
+        int64_t expected;
+        
+        if (filled < 9) {
+            window[filled] = interval;
+            filled++;
+        } else {
+            for (int32_t k = 1; k < 9; k++) {
+                window[k - 1] = window[k];
+            }
+            window[8] = interval;
+        }
+        n = filled;
+        for (int32_t a = 0; a < n; a++) {
+            sorted[a] = window[a];
+            for (int32_t b = a; b > 0 && sorted[b] < sorted[b - 1]; b--) {
+                int32_t t = sorted[b];
+                sorted[b] = sorted[b - 1];
+                sorted[b - 1] = t;
+            }
+        }
+        expected = ((n % 2) != 0) ? ((int64_t)sorted[n / 2] * Q16_ONE) :
+                   ((((int64_t)sorted[(n / 2) - 1] + sorted[n / 2]) * Q16_ONE) / 2);
+        median_errors += (rate.median_interval_q16 != (int32_t)expected) ? 1 : 0;
+        
+        if (beat >= 3) {
+            outliers_injected += injected ? 1 : 0;
+            outliers_flagged += (injected && rate.outlier) ? 1 : 0;
+            false_alarms += (!injected && rate.outlier) ? 1 : 0;
+        }
+    }
+    
+    printf("Rate: %.1f BPM (median interval %.1f), outliers flagged %d/%d, false alarms %d\n",
+           (float)rate.rate_q16 / (float)Q16_ONE,
+           (float)rate.median_interval_q16 / (float)Q16_ONE,
+           outliers_flagged, outliers_injected, false_alarms);
+    
+    TEST_ASSERT(first == PEAK_FP_BUFFER_TOO_SMALL && median_errors == 0,
+                "Running median matches a sorted window");
+    TEST_ASSERT(rate.rate_q16 > (72 * Q16_ONE) && rate.rate_q16 < (78 * Q16_ONE),
+                "Rate estimate near 75 BPM");
+    TEST_ASSERT(outliers_flagged == outliers_injected && false_alarms == 0,
+                "Missed and spurious beats flagged");
+    
+    /* A 40000-sample dropout is out of range and restarts the interval */
+    median_before_gap = rate.median_interval_q16;
+    index += 40000;
+    gap = peak_rate_push(&est, index, &rate);
+    TEST_ASSERT(gap == PEAK_FP_INVALID_INPUT && rate.interval == 40000 && rate.outlier,
+                "Over-long interval reported, not clamped");
+    index += 200;
+    after_gap = peak_rate_push(&est, index, &rate);
+    TEST_ASSERT(after_gap == PEAK_FP_OK && rate.interval == 200 &&
+                rate.median_interval_q16 >= (median_before_gap - (5 * Q16_ONE)) &&
+                rate.median_interval_q16 <= (median_before_gap + (5 * Q16_ONE)),
+                "Window unchanged by the out-of-range interval");
+    
+    /* Stream indices wrap modulo 2^31; intervals keep their length */
+    int32_t wrap_errors = 0;
+    PeakResultFP repeat;
+    
+    (void)peak_rate_init(&est, &rate_config);
+    index = (int32_t)(PEAK_STREAM_INDEX_MASK - 450U);
+    (void)peak_rate_push(&est, index, &rate);
+    for (int32_t beat = 0; beat < 6; beat++) {
+        index = (int32_t)(((uint32_t)index + 200U) & PEAK_STREAM_INDEX_MASK);
+        wrap_errors += ((peak_rate_push(&est, index, &rate) != PEAK_FP_OK) ||
+                        (rate.interval != 200)) ? 1 : 0;
+    }
+    repeat = peak_rate_push(&est, index, &rate);
+    printf("Across the 2^31 wrap: last index %d, rate %.1f BPM\n", index,
+           (float)rate.rate_q16 / (float)Q16_ONE);
+    TEST_ASSERT(wrap_errors == 0 && index < 1000 && rate.rate_q16 == (75 * Q16_ONE) &&
+                repeat == PEAK_FP_INVALID_INPUT,
+                "Intervals measured across the index wrap");
+}
+
+/*!
+ * @brief Test 22: Autocorrelation period gates the peak search
+ */
+static void test_autocorr_period(void)
+{
+    printf("\n=== Test 22: Autocorrelation Period ===\n");
+    
+    static int16_t signal[4000];
+    static int16_t full_scale[300000];
+    static int32_t work[PEAK_PERIOD_WORK(4000, 1000)];
+    static PeakInfoFP peaks[64];
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    PeakConfigFP config = { PEAK_Q_SAMPLES(15), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    int32_t period_direct = -1;
+    int32_t period_fft = -1;
+    int32_t strength_direct = 0;
+    int32_t strength_fft = 0;
+    int32_t period_long = -1;
+    int32_t strength_long = 0;
+    int32_t num_peaks = 0;
+    int32_t on_beat = 0;
+    int32_t all_peaks = 0;
+    int32_t best_prominence = INT32_MIN;
+    int32_t num_huge = 0;
+    PeakResultFP result;
+    PeakResultFP result_huge;
+    
+    /* ECG-like: R waves every 210 samples, T waves and noise in between */
+    gen_config.seed = 69U;
+    gen_config.baseline = 0;
+    gen_config.pulse_shape = SIGNAL_PULSE_QRS;
+    gen_config.pulse_amplitude = 90;
+    gen_config.pulse_amplitude_spread = 20;
+    gen_config.pulse_width = 3;
+    gen_config.pulse_first = 60;
+    gen_config.pulse_period = 210;
+    gen_config.noise_rms = 2;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, signal, 4000);
+    
+    (void)peak_period_estimate(signal, 4000, 50, 1000, NULL, 0, &period_direct, &strength_direct);
+    (void)peak_period_estimate(signal, 4000, 50, 1000, work,
+                               (int32_t)(sizeof(work) / sizeof(work[0])), &period_fft, &strength_fft);
+    result = find_peaks_autoperiod_fp(signal, 4000, 50, 1000, work,
+                                      (int32_t)(sizeof(work) / sizeof(work[0])),
+                                      peaks, 64, &num_peaks, &config);
+    
+    for (int32_t k = 0; k < num_peaks; k++) {
+        int32_t offset = (peaks[k].index - 60) % 210;
+        on_beat += ((offset <= 3) || (offset >= 207)) ? 1 : 0;
+    }
+    (void)peak_iter_init(&iter, signal, 4000, &config);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        all_peaks++;
+        best_prominence = (peak.prominence_q16 > best_prominence) ? peak.prominence_q16 :
+                          best_prominence;
+    }
+    
+    /* A period beyond the signal leaves one window: the whole signal */
+    result_huge = find_periodic_peaks_fp(signal, 4000, INT32_MAX, peaks, 64, &num_huge, &config);
+    
+    printf("Period: direct %d (strength %.3f), FFT %d (strength %.3f)\n",
+           period_direct, (float)strength_direct / (float)Q16_ONE,
+           period_fft, (float)strength_fft / (float)Q16_ONE);
+    printf("Gated peaks: %d (%d on an R wave), ungated peaks above threshold: %d\n",
+           num_peaks, on_beat, all_peaks);
+    
+    TEST_ASSERT(period_direct == 210 && period_fft == period_direct &&
+                strength_fft == strength_direct,
+                "Direct and FFT autocorrelation agree on the period");
+    TEST_ASSERT(result == PEAK_FP_OK && num_peaks == 19 && on_beat == num_peaks,
+                "One peak per period, each on an R wave");
+    TEST_ASSERT(result_huge == PEAK_FP_OK && num_huge == 1 &&
+                peaks[0].prominence_q16 == best_prominence,
+                "Period of INT32_MAX finds the single best peak");
+    
+    /* Full-scale square wave, period 50: r[0] * Q16_ONE would overflow int64 */
+    for (int32_t i = 0; i < 300000; i++) {
+        full_scale[i] = ((i % 50) < 25) ? INT16_MAX : -INT16_MAX;
+    }
+    (void)peak_period_estimate(full_scale, 300000, 10, 64, NULL, 0, &period_long, &strength_long);
+    printf("Full-scale 300000 samples: period %d (strength %.4f)\n",
+           period_long, (float)strength_long / (float)Q16_ONE);
+    TEST_ASSERT(period_long == 50 && strength_long > ((Q16_ONE * 99) / 100) &&
+                strength_long <= Q16_ONE,
+                "Strength stays in range for long full-scale input");
+}
+
+/*!
+ * @brief Test 23: Peak identities persist across frames
+ */
+static void test_peak_tracker(void)
+{
+    printf("\n=== Test 23: Frame-to-Frame Peak Tracking ===\n");
+    
+    static int16_t frame[1024];
+    PeakTrackerConfigFP track_config = { 8 * Q16_ONE, Q16_ONE / 2, Q16_ONE / 10, 2 };
+    PeakConfigFP config = { PEAK_Q_SAMPLES(20), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    PeakTrackerFP tracker;
+    PeakTrackFP tracks[PEAK_TRACK_MAX];
+    PeakInfoFP peaks[8];
+    PeakIteratorFP iter;
+    int32_t ids[8];
+    int32_t line_id[3] = { PEAK_TRACK_NONE, PEAK_TRACK_NONE, PEAK_TRACK_NONE };
+    int32_t id_switches = 0;
+    int32_t num_tracks = 0;
+    int32_t tracks_after_death = 0;
+    PeakResultFP wide_first;
+    PeakResultFP wide_second;
+    PeakInfoFP wide_peaks[20];
+    int32_t wide_ids[20];
+    
+    (void)peak_tracker_init(&tracker, &track_config);
+    
+    for (int32_t f = 0; f < 40; f++) {
+        /* Line 0 drifts up, line 1 drifts down and ends at frame 25, line 2 starts at frame 10 */
+        int32_t centre[3] = { 200 + (3 * f), 600 - (2 * f), 850 + (f / 4) };
+        bool present[3] = { true, f < 25, f >= 10 };
+        int32_t num_peaks = 0;
+        
+        for (int32_t i = 0; i < 1024; i++) {
+            frame[i] = 10;
+        }
+        for (int32_t line = 0; line < 3; line++) {
+            for (int32_t d = -10; present[line] && (d <= 10); d++) {
+                frame[centre[line] + d] = (int16_t)(110 - (10 * (d < 0 ? -d : d)));
+            }
+        }
+        
+        (void)peak_iter_init(&iter, frame, 1024, &config);
+        while ((num_peaks < 8) && (peak_iter_next(&iter, &peaks[num_peaks]) == PEAK_FP_OK)) {
+            num_peaks++;
+        }
+        (void)peak_tracker_update(&tracker, peaks, num_peaks, ids);
+        
+        for (int32_t k = 0; k < num_peaks; k++) {
+            for (int32_t line = 0; line < 3; line++) {
+                if (present[line] && (peaks[k].index == centre[line])) {
+                    id_switches += ((line_id[line] != PEAK_TRACK_NONE) && (line_id[line] != ids[k])) ? 1 : 0;
+                    line_id[line] = ids[k];
+                }
+            }
+        }
+        
+        (void)peak_tracker_tracks(&tracker, tracks, PEAK_TRACK_MAX, &num_tracks);
+        if (f == 28) {
+            tracks_after_death = num_tracks;
+        }
+    }
+    
+    printf("Line ids: %d %d %d, id switches: %d, tracks after line 1 ended: %d\n",
+           line_id[0], line_id[1], line_id[2], id_switches, tracks_after_death);
+    
+    TEST_ASSERT(id_switches == 0 && line_id[0] == 0 && line_id[1] == 1 && line_id[2] == 2,
+                "Each line keeps one track id across frames");
+    TEST_ASSERT(tracks_after_death == 2 && tracker.next_id == 3,
+                "Ended line's track is retired, no spurious births");
+    
+    /* 20 tracks and peaks inside one wide gate: 400 pairs, more than PEAK_TRACK_PAIRS_MAX */
+    track_config.gate_q16 = 1000 * Q16_ONE;
+    (void)peak_tracker_init(&tracker, &track_config);
+    for (int32_t k = 0; k < 20; k++) {
+        wide_peaks[k].index = 10 * (k + 1);
+        wide_peaks[k].value = 100;
+        wide_peaks[k].prominence_q16 = PEAK_Q_SAMPLES(50);
+    }
+    wide_first = peak_tracker_update(&tracker, wide_peaks, 20, wide_ids);
+    wide_second = peak_tracker_update(&tracker, wide_peaks, 20, wide_ids);
+    
+    printf("Wide gate: second frame %d, %d pairs dropped (pairs cap %d)\n",
+           (int)wide_second, tracker.pairs_dropped, PEAK_TRACK_PAIRS_MAX);
+    TEST_ASSERT(wide_first == PEAK_FP_OK && wide_second == PEAK_FP_OK &&
+                tracker.pairs_dropped == ((20 * 20) - PEAK_TRACK_PAIRS_MAX) &&
+                wide_ids[0] == 0 && wide_ids[1] == 1,
+                "Dropped gated pairs counted, update still applied");
+}
+
+/*!
+ * @brief Reference coincidence pass: scan every channel head per window.
+ */
+static int32_t naive_coincidences(const PeakListFP lists[], int32_t channels, int32_t tolerance,
+                                  int32_t min_channels, PeakCoincidenceFP events[])
+{
+    int32_t cursor[8] = { 0 };
+    int32_t count = 0;
+    
+    for (;;) {
+        int32_t opening = -1;
+        int32_t size = 0;
+        uint32_t mask = 0U;
+        
+        for (int32_t c = 0; c < channels; c++) {
+            if ((cursor[c] < lists[c].count) &&
+                ((opening < 0) || (lists[c].peaks[cursor[c]].index < lists[opening].peaks[cursor[opening]].index))) {
+                opening = c;
+            }
+        }
+        if (opening < 0) {
+            return count;
+        }
+        for (int32_t c = 0; c < channels; c++) {
+            if ((cursor[c] < lists[c].count) &&
+                (lists[c].peaks[cursor[c]].index <= (lists[opening].peaks[cursor[opening]].index + tolerance))) {
+                mask |= 1U << c;
+                size++;
+            }
+        }
+        if (size < min_channels) {
+            cursor[opening]++;
+            continue;
+        }
+        events[count].index = lists[opening].peaks[cursor[opening]].index;
+        events[count].channel_mask = mask;
+        count++;
+        for (int32_t c = 0; c < channels; c++) {
+            cursor[c] += ((mask >> c) & 1U) ? 1 : 0;
+        }
+    }
+}
+
+/*!
+ * @brief Test 24: Coincidences across channels of a detector array
+ */
+static void test_coincidence(void)
+{
+    printf("\n=== Test 24: Cross-Channel Coincidence ===\n");
+    
+    static int16_t channel_signal[6][4096];
+    static uint64_t arena_memory[6][256];
+    static PeakCoincidenceFP events[64];
+    static PeakCoincidenceFP reference[64];
+    PeakConfigFP config = { PEAK_Q_SAMPLES(20), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    PeakCoincConfigFP coinc_config = { 3, 4 };
+    PeakArenaFP arena[6];
+    PeakListFP lists[6];
+    SignalRng rng;
+    uint32_t injected_mask[20];
+    int32_t num_events = 0;
+    int32_t num_reference;
+    int32_t recovered = 0;
+    int32_t mismatches = 0;
+    PeakResultFP result;
+    
+    signal_rng_seed(&rng, 71U, 1U);
+    for (int32_t c = 0; c < 6; c++) {
+        for (int32_t i = 0; i < 4096; i++) {
+            channel_signal[c][i] = 10;
+        }
+    }
+    
+    /* 20 events on 4-6 channels with +/-1 sample skew, plus 12 stray pulses per channel */
+    for (int32_t e = 0; e < 20; e++) {
+        injected_mask[e] = 0U;
+        for (int32_t c = 0; c < 6; c++) {
+            if ((c < 4) || (signal_rng_below(&rng, 2U) == 0U)) {
+                int32_t centre = 100 + (200 * e) + (int32_t)signal_rng_below(&rng, 3U) - 1;
+                
+                injected_mask[e] |= 1U << c;
+                for (int32_t d = -5; d <= 5; d++) {
+                    channel_signal[c][centre + d] = (int16_t)(110 - (15 * (d < 0 ? -d : d)));
+                }
+            }
+        }
+    }
+    for (int32_t c = 0; c < 6; c++) {
+        for (int32_t k = 0; k < 12; k++) {
+            int32_t centre = 10 + (int32_t)signal_rng_below(&rng, 4070U);
+            
+            for (int32_t d = -3; d <= 3; d++) {
+                channel_signal[c][centre + d] = (int16_t)(90 - (20 * (d < 0 ? -d : d)));
+            }
+        }
+        peak_arena_init(&arena[c], arena_memory[c], sizeof(arena_memory[c]));
+        (void)find_peaks_arena_fp(channel_signal[c], 4096, &config, &arena[c], &lists[c]);
+    }
+    
+    result = find_coincidences_fp(lists, 6, &coinc_config, events, 64, &num_events);
+    num_reference = naive_coincidences(lists, 6, 3, 4, reference);
+    
+    for (int32_t e = 0; e < num_events; e++) {
+        int32_t slot = (events[e].index - 98) / 200;
+        
+        if ((((events[e].index - 98) % 200) <= 2) && (events[e].channel_mask == injected_mask[slot])) {
+            recovered++;
+        }
+        if ((e >= num_reference) || (events[e].index != reference[e].index) ||
+            (events[e].channel_mask != reference[e].channel_mask)) {
+            mismatches++;
+        }
+    }
+    
+    printf("Events: %d (reference %d), injected events recovered with exact mask: %d/20\n",
+           num_events, num_reference, recovered);
+    
+    TEST_ASSERT(result == PEAK_FP_OK && num_events == num_reference && mismatches == 0,
+                "k-way merge matches the per-channel scan");
+    TEST_ASSERT(recovered == 20, "Every injected event found with its channels");
+}
+
+/*!
+ * @brief Test 25: Full-scale int16 swings saturate instead of wrapping
+ */
+static void test_full_scale(void)
+{
+    printf("\n=== Test 25: Full-Scale Signals ===\n");
+    
+    int16_t signal[64];
+    PeakConfigFP config = { PROMINENCE_THRESHOLD_Q16, GRADIENT_THRESHOLD_Q16, INT32_MIN };  /* No noise floor */
+    PeakIteratorFP iter;
+    PeakInfoFP peaks[4];
+    int32_t num_peaks = 0;
+    int32_t peak_index = -1;
+    float prominence_float;
+    PeakResultFP result;
+    
+    /* Rail-to-rail pulse (65535.0 does not fit Q16.16) and a smaller pulse;
+     * the rails of a Q8.8 build are -128 and 127 */
+#if PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+    const int16_t rail_low = -128;
+    const int16_t rail_high = 127;
+    const int16_t small_top = -40;
+#else
+    const int16_t rail_low = INT16_MIN;
+    const int16_t rail_high = INT16_MAX;
+    const int16_t small_top = -10000;
+#endif
+    for (int32_t i = 0; i < 64; i++) {
+        signal[i] = rail_low;
+    }
+    signal[19] = 0;
+    signal[20] = rail_high;
+    signal[21] = 0;
+    signal[40] = small_top;
+    
+    result = find_prominent_peak_fp(signal, 64, &peak_index, NULL);
+    prominence_float = get_peak_prominence_float(signal, 64, 20);
+    (void)peak_iter_init(&iter, signal, 64, &config);
+    while ((num_peaks < 4) && (peak_iter_next(&iter, &peaks[num_peaks]) == PEAK_FP_OK)) {
+        num_peaks++;
+    }
+    
+    printf("Best peak: %d, float prominence %.1f, iterator peaks %d (prominences %ld, %ld)\n",
+           peak_index, prominence_float, num_peaks,
+           (long)peaks[0].prominence_q16, (long)peaks[1].prominence_q16);
+    
+    TEST_ASSERT(result == PEAK_FP_OK && peak_index == 20 &&
+                prominence_float == TEST_STEPS(rail_high - rail_low),
+                "Rail-to-rail pulse found with exact float prominence");
+    TEST_ASSERT(num_peaks == 2 &&
+                peaks[0].prominence_q16 == ((PEAK_Q_SAMPLE_SHIFT == 16) ? INT32_MAX :
+                                            PEAK_Q_SAMPLES(rail_high - rail_low)) &&
+                peaks[1].prominence_q16 == PEAK_Q_SAMPLES(small_top - rail_low),
+                "Q16.16 prominence saturates, smaller pulse stays exact");
+    
+#if PEAK_FP_Q_FORMAT == PEAK_Q_8_8
+    /* The int16_t rails clamp to the Q8.8 ones on every path */
+    PeakInfoFP clamped[4];
+    int32_t num_clamped = 0;
+    int32_t clamped_index = -1;
+    bool same = true;
+    
+    for (int32_t i = 0; i < 64; i++) {
+        signal[i] = (signal[i] == rail_low) ? INT16_MIN : signal[i];
+    }
+    signal[20] = INT16_MAX;
+    (void)find_prominent_peak_fp(signal, 64, &clamped_index, NULL);
+    (void)peak_iter_init(&iter, signal, 64, &config);
+    while ((num_clamped < 4) && (peak_iter_next(&iter, &clamped[num_clamped]) == PEAK_FP_OK)) {
+        same = same && (clamped[num_clamped].index == peaks[num_clamped].index) &&
+               (clamped[num_clamped].value == peaks[num_clamped].value) &&
+               (clamped[num_clamped].prominence_q16 == peaks[num_clamped].prominence_q16);
+        num_clamped++;
+    }
+    
+    printf("Out-of-range rails: best peak %d, iterator peaks %d, top value %d\n",
+           clamped_index, num_clamped, clamped[0].value);
+    TEST_ASSERT(clamped_index == peak_index && num_clamped == num_peaks && same &&
+                clamped[0].value == rail_high,
+                "Frame and raw-sample paths clamp alike");
+#endif
+}
+
+#define LONG_TOTAL ((3 * 65536) + 1000)
+
+static int16_t s_long_source[LONG_TOTAL];
+static PeakInfoFP s_long_peaks[4096];
+
+/*!
+ * @brief Ping-pong over s_long_source from a given stream position,
+ *        compared with the iterator
+ *
+ * @return Number of peaks that differ
+ */
+static int32_t long_pingpong_mismatches(const PeakConfigFP *config, uint32_t start,
+                                        int32_t *num_expected, int32_t *num_found)
+{
+    PeakIteratorFP iter;
+    PeakInfoFP peak;
+    int32_t pp_count = 0;
+    int32_t flushed = 0;
+    int32_t mismatches = 0;
+    int32_t expected = 0;
+    
+    (void)peak_pingpong_init(&s_pp, s_pp_stack, DMA_HALF * 4, DMA_HALF * 2, config);
+    s_pp.position = start;  /* As if start samples had already passed */
+    for (int32_t pos = 0; pos < LONG_TOTAL; pos += DMA_HALF) {
+        int32_t n = 0;
+        int32_t count = ((LONG_TOTAL - pos) < DMA_HALF) ? (LONG_TOTAL - pos) : DMA_HALF;
+        
+        (void)peak_pingpong_process(&s_pp, &s_long_source[pos], count,
+                                    &s_long_peaks[pp_count], 4096 - pp_count, &n);
+        pp_count += n;
+    }
+    (void)peak_pingpong_flush(&s_pp, &s_long_peaks[pp_count], 4096 - pp_count, &flushed);
+    pp_count += flushed;
+    
+    /* Back to source indices, then sort: finalisation order differs */
+    for (int32_t i = 0; i < pp_count; i++) {
+        s_long_peaks[i].index = (int32_t)(((uint32_t)s_long_peaks[i].index - start) &
+                                          PEAK_STREAM_INDEX_MASK);
+    }
+    for (int32_t i = 1; i < pp_count; i++) {
+        PeakInfoFP key = s_long_peaks[i];
+        int32_t k = i - 1;
+        
+        while ((k >= 0) && (s_long_peaks[k].index > key.index)) {
+            s_long_peaks[k + 1] = s_long_peaks[k];
+            k--;
+        }
+        s_long_peaks[k + 1] = key;
+    }
+    
+    (void)peak_iter_init(&iter, s_long_source, LONG_TOTAL, config);
+    while (peak_iter_next(&iter, &peak) == PEAK_FP_OK) {
+        if ((expected >= pp_count) || (s_long_peaks[expected].index != peak.index) ||
+            (s_long_peaks[expected].prominence_q16 != peak.prominence_q16)) {
+            mismatches++;
+        }
+        expected++;
+    }
+    
+    *num_expected = expected;
+    *num_found = pp_count;
+    return mismatches;
+}
+
+/*!
+ * @brief Sliding window over s_long_source from a given stream position,
+ *        compared with re-detection on each window
+ *
+ * @return Number of windows that differ
+ */
+static int32_t long_slide_mismatches(const PeakConfigFP *config, uint32_t origin,
+                                     int32_t *num_windows)
+{
+    PeakSlideFP slide;
+    int32_t windows = 0;
+    int32_t mismatches = 0;
+    
+    (void)peak_slide_init(&slide, s_slide_samples, s_slide_blocks, s_slide_cands,
+                          SLIDE_WINDOW, SLIDE_HOP, config);
+    slide.origin = origin;  /* As if origin samples had already passed */
+    for (int32_t pos = 0; (pos + SLIDE_HOP) <= LONG_TOTAL; pos += SLIDE_HOP) {
+        int32_t idx = -1;
+        int32_t ref_idx = -1;
+        int32_t first = pos + SLIDE_HOP - SLIDE_WINDOW;
+        PeakResultFP result = peak_slide_push(&slide, &s_long_source[pos], &idx);
+        
+        if (first < 0) {
+            continue;
+        }
+        
+        PeakResultFP ref = find_prominent_peak_fp(&s_long_source[first], SLIDE_WINDOW, &ref_idx, config);
+        uint32_t stream_first = origin + (uint32_t)first;
+        if ((result != ref) ||
+            (peak_slide_window_start(&slide) != (int32_t)(stream_first & PEAK_STREAM_INDEX_MASK)) ||
+            ((ref == PEAK_FP_OK) &&
+             (idx != (int32_t)((stream_first + (uint32_t)ref_idx) & PEAK_STREAM_INDEX_MASK)))) {
+            mismatches++;
+        }
+        windows++;
+    }
+    
+    *num_windows = windows;
+    return mismatches;
+}
+
+/*!
+ * @brief Test 26: Stream engines keep exact indices past 2^16 samples
+ */
+static void test_long_stream(void)
+{
+    printf("\n=== Test 26: Long Streams ===\n");
+    
+    SignalGenConfig gen_config = { 0 };
+    SignalGen gen;
+    PeakConfigFP config = { PEAK_Q_SAMPLES(15), GRADIENT_THRESHOLD_Q16, NOISE_FLOOR_Q16 };
+    int32_t windows = 0;
+    int32_t slide_mismatches;
+    int32_t slide_wrap_mismatches;
+    int32_t pp_count = 0;
+    int32_t pp_mismatches;
+    int32_t pp_wrap_mismatches;
+    int32_t expected = 0;
+    
+    printf("Entry sizes: stack %u, slide candidate %u bytes\n",
+           (unsigned)sizeof(PeakStackEntryFP), (unsigned)sizeof(PeakSlideCandidateFP));
+    
+    /* Noisy pulses for the sliding window */
+    gen_config.seed = 27U;
+    gen_config.baseline = 0;
+    gen_config.wander_amplitude = 8;
+    gen_config.wander_step = 0x00100000U;
+    gen_config.pulse_shape = SIGNAL_PULSE_QRS;
+    gen_config.pulse_amplitude = 90;
+    gen_config.pulse_amplitude_spread = 20;
+    gen_config.pulse_width = 5;
+    gen_config.pulse_first = 40;
+    gen_config.pulse_period = 180;
+    gen_config.pulse_jitter = 60;
+    gen_config.noise_rms = 1;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, s_long_source, LONG_TOTAL);
+    
+    /* From the start, then from 100000 samples before 2^32 */
+    slide_mismatches = long_slide_mismatches(&config, 0U, &windows);
+    slide_wrap_mismatches = long_slide_mismatches(&config, 0U - 100000U, &windows);
+    
+    /* Identical noise-free pulses: every right walk ends within the horizon */
+    gen_config.wander_amplitude = 0;
+    gen_config.pulse_amplitude_spread = 0;
+    gen_config.pulse_jitter = 0;
+    gen_config.noise_rms = 0;
+    signal_gen_init(&gen, &gen_config);
+    signal_gen_block(&gen, s_long_source, LONG_TOTAL);
+    
+    /* From the start, then from 100000 samples before the position wraps */
+    pp_mismatches = long_pingpong_mismatches(&config, 0U, &expected, &pp_count);
+    pp_wrap_mismatches = long_pingpong_mismatches(&config, 0U - 100000U, &expected, &pp_count);
+    
+    printf("Slide windows: %d, mismatches: %d (%d across the wrap); "
+           "ping-pong peaks: %d of %d, mismatches: %d (%d across the wrap)\n",
+           windows, slide_mismatches, slide_wrap_mismatches,
+           pp_count, expected, pp_mismatches, pp_wrap_mismatches);
+    
+    TEST_ASSERT(windows == ((LONG_TOTAL - SLIDE_WINDOW) / SLIDE_HOP) + 1 && slide_mismatches == 0,
+                "Sliding window matches re-detection past 2^16 samples");
+    TEST_ASSERT(expected > 1000 && pp_count == expected && pp_mismatches == 0,
+                "Ping-pong indices exact past 2^16 samples");
+    TEST_ASSERT(slide_wrap_mismatches == 0, "Sliding window runs across the position wrap");
+    TEST_ASSERT(pp_wrap_mismatches == 0, "Ping-pong runs across the position wrap");
+}
+
 /*!
  * @brief Main test runner
  */
@@ -313,9 +1946,6 @@ int main(void)
     printf("║  Fixed-Point Peak Detection Validation    ║\n");
     printf("╚════════════════════════════════════════════╝\n");
     
-    /* Seed random number generator */
-    srand(12345);
-    
     /* Run test suite */
     test_simple_peak();
     test_multiple_peaks();
@@ -324,6 +1954,25 @@ int main(void)
     test_edge_cases();
     test_custom_config();
     test_adc_data();
+    test_lazy_iterator();
+    test_pipeline();
+    test_stream();
+    test_arena_batch();
+    test_stats();
+    test_telemetry();
+    test_signal_gen();
+    test_sample_ring();
+    test_two_spans();
+    test_circular();
+    test_pingpong_dma();
+    test_sliding_window();
+    test_roi_mask();
+    test_peak_rate();
+    test_autocorr_period();
+    test_peak_tracker();
+    test_coincidence();
+    test_full_scale();
+    test_long_stream();
     
     /* Print summary */
     printf("\n");
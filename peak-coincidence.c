@@ -0,0 +1,258 @@
+/*!
+ * Cross-Channel Coincidence Detection
+ *
+ * The merge heap holds one entry per channel that still has peaks. The
+ * key is the index of that channel's head peak, and the channel number
+ * breaks ties. pos[] maps each channel to its heap position, so a
+ * participating channel that is not at the top can still be advanced in
+ * O(log C).
+ */
+
+#include <stddef.h>
+#include "peak-coincidence.h"
+
+typedef struct {
+    const PeakListFP *lists;
+    int32_t cursor[PEAK_COINC_CHANNELS_MAX];  /* Head peak per channel */
+    int8_t heap[PEAK_COINC_CHANNELS_MAX];     /* Channels, earliest head first */
+    int8_t pos[PEAK_COINC_CHANNELS_MAX];      /* Heap position per channel */
+    int32_t count;
+} CoincMerge;
+
+/*!
+ * @brief Index of a channel's head peak.
+ */
+static inline int32_t coinc_key(const CoincMerge *merge, int32_t channel)
+{
+    return merge->lists[channel].peaks[merge->cursor[channel]].index;
+}
+
+/*!
+ * @brief True if channel a belongs above channel b in the heap.
+ */
+static inline bool coinc_before(const CoincMerge *merge, int32_t a, int32_t b)
+{
+    int32_t key_a = coinc_key(merge, a);
+    int32_t key_b = coinc_key(merge, b);
+
+    return (key_a < key_b) || ((key_a == key_b) && (a < b));
+}
+
+static inline void coinc_set(CoincMerge *merge, int32_t pos, int32_t channel)
+{
+    merge->heap[pos] = (int8_t)channel;
+    merge->pos[channel] = (int8_t)pos;
+}
+
+static void coinc_sift_up(CoincMerge *merge, int32_t pos)
+{
+    int32_t channel = merge->heap[pos];
+
+    while (pos > 0) {
+        int32_t parent = (pos - 1) / 2;
+
+        if (!coinc_before(merge, channel, merge->heap[parent])) {
+            break;
+        }
+        coinc_set(merge, pos, merge->heap[parent]);
+        pos = parent;
+    }
+    coinc_set(merge, pos, channel);
+}
+
+static void coinc_sift_down(CoincMerge *merge, int32_t pos)
+{
+    int32_t channel = merge->heap[pos];
+
+    for (;;) {
+        int32_t child = (2 * pos) + 1;
+
+        if (child >= merge->count) {
+            break;
+        }
+        if (((child + 1) < merge->count) &&
+            coinc_before(merge, merge->heap[child + 1], merge->heap[child])) {
+            child++;
+        }
+        if (!coinc_before(merge, merge->heap[child], channel)) {
+            break;
+        }
+        coinc_set(merge, pos, merge->heap[child]);
+        pos = child;
+    }
+    coinc_set(merge, pos, channel);
+}
+
+/*!
+ * @brief Move a channel to its next peak, or drop it when exhausted.
+ */
+static void coinc_advance(CoincMerge *merge, int32_t channel)
+{
+    int32_t pos = merge->pos[channel];
+    int32_t moved;
+
+    merge->cursor[channel]++;
+    if (merge->cursor[channel] < merge->lists[channel].count) {
+        /* Key only grew */
+        coinc_sift_down(merge, pos);
+        return;
+    }
+
+    merge->count--;
+    if (pos == merge->count) {
+        return;
+    }
+    moved = merge->heap[merge->count];
+    coinc_set(merge, pos, moved);
+    coinc_sift_up(merge, pos);
+    coinc_sift_down(merge, merge->pos[moved]);
+}
+
+/*!
+ * @brief Collect the channels whose head lies at or before limit.
+ *
+ * Walks the heap from the top and prunes every subtree whose root is
+ * already past the limit, so the walk visits at most 2m + 1 nodes.
+ *
+ * @return Number of channels written to members
+ */
+static int32_t coinc_window(const CoincMerge *merge, int32_t limit, int8_t members[])
+{
+    int8_t stack[PEAK_COINC_CHANNELS_MAX];
+    int32_t depth = 0;
+    int32_t count = 0;
+    int32_t child;
+
+    stack[depth] = 0;
+    depth++;
+    while (depth > 0) {
+        int32_t node;
+        int32_t channel;
+
+        depth--;
+        node = stack[depth];
+        channel = merge->heap[node];
+        if (coinc_key(merge, channel) > limit) {
+            continue;
+        }
+        members[count] = (int8_t)channel;
+        count++;
+        for (child = (2 * node) + 1; child <= ((2 * node) + 2); child++) {
+            if (child < merge->count) {
+                stack[depth] = (int8_t)child;
+                depth++;
+            }
+        }
+    }
+
+    return count;
+}
+
+/*!
+ * @brief Find peaks that coincide across channels.
+ *
+ * Repeatedly opens a window at the earliest unused peak. The window
+ * takes the head peak of every channel with an index no more than
+ * tolerance past that peak. A window with at least min_channels
+ * channels becomes an event and uses up those peaks. Otherwise only the
+ * opening peak is dropped. A channel contributes at most one peak per
+ * event, its earliest one.
+ *
+ * @param lists One peak list per channel, sorted by index (e.g. from
+ *        find_peaks_arena_fp())
+ * @param num_channels Number of channels (1 .. PEAK_COINC_CHANNELS_MAX)
+ * @param config Tolerance and minimum channel count
+ * @param events Output array, in time order
+ * @param max_events Capacity of events
+ * @param num_events Output: number of events written
+ * @return PEAK_FP_OK if at least one event was found,
+ *         PEAK_FP_NO_PEAK_FOUND if none, PEAK_FP_BUFFER_TOO_SMALL if
+ *         events filled up, PEAK_FP_INVALID_INPUT otherwise
+ */
+PeakResultFP find_coincidences_fp(const PeakListFP lists[],
+                                  int32_t num_channels,
+                                  const PeakCoincConfigFP *config,
+                                  PeakCoincidenceFP events[],
+                                  int32_t max_events,
+                                  int32_t *num_events)
+{
+    CoincMerge merge;
+    int8_t members[PEAK_COINC_CHANNELS_MAX];
+    int32_t count = 0;
+    int32_t c;
+    int32_t k;
+    int32_t m;
+
+    if ((lists == NULL) || (config == NULL) || (events == NULL) || (num_events == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if ((num_channels < 1) || (num_channels > PEAK_COINC_CHANNELS_MAX) ||
+        (config->tolerance < 0) || (config->min_channels < 1) ||
+        (config->min_channels > num_channels) || (max_events < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    *num_events = 0;
+    merge.lists = lists;
+    merge.count = 0;
+    for (c = 0; c < num_channels; c++) {
+        if ((lists[c].count < 0) || ((lists[c].peaks == NULL) && (lists[c].count > 0))) {
+            return PEAK_FP_INVALID_INPUT;
+        }
+        for (k = 1; k < lists[c].count; k++) {
+            if (lists[c].peaks[k].index < lists[c].peaks[k - 1].index) {
+                return PEAK_FP_INVALID_INPUT;
+            }
+        }
+        merge.cursor[c] = 0;
+        if (lists[c].count > 0) {
+            coinc_set(&merge, merge.count, c);
+            merge.count++;
+            coinc_sift_up(&merge, merge.count - 1);
+        }
+    }
+
+    while (merge.count > 0) {
+        int32_t opening = merge.heap[0];
+        int32_t first = coinc_key(&merge, opening);
+        int32_t limit = ((int64_t)first + config->tolerance > INT32_MAX) ?
+                        INT32_MAX : (first + config->tolerance);
+        int32_t size = coinc_window(&merge, limit, members);
+        PeakCoincidenceFP event;
+        int64_t prominence = 0;
+        int32_t last = first;
+
+        if (size < config->min_channels) {
+            coinc_advance(&merge, opening);
+            continue;
+        }
+
+        if (count == max_events) {
+            *num_events = count;
+            return PEAK_FP_BUFFER_TOO_SMALL;
+        }
+
+        event.channel_mask = 0U;
+        for (m = 0; m < size; m++) {
+            const PeakInfoFP *peak = &lists[members[m]].peaks[merge.cursor[members[m]]];
+
+            event.channel_mask |= 1U << members[m];
+            prominence += peak->prominence_q16;
+            last = (peak->index > last) ? peak->index : last;
+        }
+        event.index = first;
+        event.span = last - first;
+        event.channel_count = size;
+        event.prominence_q16 = (prominence > INT32_MAX) ? INT32_MAX : (int32_t)prominence;
+        events[count] = event;
+        count++;
+
+        for (m = 0; m < size; m++) {
+            coinc_advance(&merge, members[m]);
+        }
+    }
+
+    *num_events = count;
+    return (count > 0) ? PEAK_FP_OK : PEAK_FP_NO_PEAK_FOUND;
+}
@@ -0,0 +1,54 @@
+/*!
+ * Cross-Channel Coincidence Detection
+ *
+ * Finds events where peaks on several synchronous channels line up
+ * within a few samples. Input is one index-sorted peak list per channel,
+ * as produced by find_peaks_arena_fp(). The channel heads are merged
+ * through a k-way min-heap. A coincidence window opens at the earliest
+ * unused peak and takes the head peak of every channel whose head falls
+ * within the tolerance, like a hardware coincidence trigger. Each
+ * window costs O(m log C), where m is the number of participating
+ * channels. No allocation.
+ */
+
+#ifndef PEAK_COINCIDENCE_H
+#define PEAK_COINCIDENCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "embedded-signal-peaks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest channel count (one bit per channel in the event mask) */
+#define PEAK_COINC_CHANNELS_MAX (32)
+
+/* Coincidence configuration */
+typedef struct {
+    int32_t tolerance;       /* Largest index difference within an event (samples) */
+    int32_t min_channels;    /* Channels needed for an event (1 .. channel count) */
+} PeakCoincConfigFP;
+
+/* One multi-channel event */
+typedef struct {
+    int32_t index;           /* Earliest peak index of the event */
+    int32_t span;            /* Latest minus earliest peak index */
+    uint32_t channel_mask;   /* Bit c set if channel c took part */
+    int32_t channel_count;
+    int32_t prominence_q16;  /* Summed prominence, saturated (detector Q format, see peak_q_t) */
+} PeakCoincidenceFP;
+
+PeakResultFP find_coincidences_fp(const PeakListFP lists[],
+                                  int32_t num_channels,
+                                  const PeakCoincConfigFP *config,
+                                  PeakCoincidenceFP events[],
+                                  int32_t max_events,
+                                  int32_t *num_events);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEAK_COINCIDENCE_H */
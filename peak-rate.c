@@ -0,0 +1,297 @@
+/*!
+ * Peak-to-Peak Interval and Rate Estimation
+ *
+ * Median window: the lower half of the intervals sits in a max-heap and
+ * the upper half in a min-heap, with the lower heap holding the extra
+ * element when the count is odd. Heap entries are ring slot numbers and
+ * slot_heap/slot_pos map each slot back to its heap position, which is
+ * what lets the oldest interval be deleted in O(log N).
+ */
+
+#include <stddef.h>
+#include "peak-rate.h"
+
+#define RATE_LOWER (0)
+#define RATE_UPPER (1)
+
+/*!
+ * @brief Heap array of a heap id.
+ */
+static inline int16_t *rate_heap(PeakRateEstimatorFP *est, int32_t heap)
+{
+    return (heap == RATE_LOWER) ? est->lower : est->upper;
+}
+
+/*!
+ * @brief Entry count of a heap id.
+ */
+static inline int32_t *rate_heap_count(PeakRateEstimatorFP *est, int32_t heap)
+{
+    return (heap == RATE_LOWER) ? &est->lower_count : &est->upper_count;
+}
+
+/*!
+ * @brief True if slot a belongs above slot b in the heap.
+ */
+static inline bool rate_before(const PeakRateEstimatorFP *est, int32_t heap, int32_t a, int32_t b)
+{
+    return (heap == RATE_LOWER) ? (est->intervals[a] > est->intervals[b]) :
+                                  (est->intervals[a] < est->intervals[b]);
+}
+
+/*!
+ * @brief Place a slot at a heap position and record where it went.
+ */
+static inline void rate_heap_set(PeakRateEstimatorFP *est, int32_t heap, int32_t pos, int32_t slot)
+{
+    rate_heap(est, heap)[pos] = (int16_t)slot;
+    est->slot_heap[slot] = (int16_t)heap;
+    est->slot_pos[slot] = (int16_t)pos;
+}
+
+static void rate_sift_up(PeakRateEstimatorFP *est, int32_t heap, int32_t pos)
+{
+    int16_t *h = rate_heap(est, heap);
+    int32_t slot = h[pos];
+
+    while (pos > 0) {
+        int32_t parent = (pos - 1) / 2;
+
+        if (!rate_before(est, heap, slot, h[parent])) {
+            break;
+        }
+        rate_heap_set(est, heap, pos, h[parent]);
+        pos = parent;
+    }
+    rate_heap_set(est, heap, pos, slot);
+}
+
+static void rate_sift_down(PeakRateEstimatorFP *est, int32_t heap, int32_t pos)
+{
+    int16_t *h = rate_heap(est, heap);
+    int32_t n = *rate_heap_count(est, heap);
+    int32_t slot = h[pos];
+
+    for (;;) {
+        int32_t child = (2 * pos) + 1;
+
+        if (child >= n) {
+            break;
+        }
+        if (((child + 1) < n) && rate_before(est, heap, h[child + 1], h[child])) {
+            child++;
+        }
+        if (!rate_before(est, heap, h[child], slot)) {
+            break;
+        }
+        rate_heap_set(est, heap, pos, h[child]);
+        pos = child;
+    }
+    rate_heap_set(est, heap, pos, slot);
+}
+
+static void rate_heap_push(PeakRateEstimatorFP *est, int32_t heap, int32_t slot)
+{
+    int32_t *n = rate_heap_count(est, heap);
+    int32_t pos = *n;
+
+    (*n)++;
+    rate_heap_set(est, heap, pos, slot);
+    rate_sift_up(est, heap, pos);
+}
+
+/*!
+ * @brief Delete the entry at a heap position (O(log N)).
+ */
+static void rate_heap_remove(PeakRateEstimatorFP *est, int32_t heap, int32_t pos)
+{
+    int16_t *h = rate_heap(est, heap);
+    int32_t *n = rate_heap_count(est, heap);
+    int32_t last;
+    int32_t moved;
+
+    (*n)--;
+    last = *n;
+    if (pos == last) {
+        return;
+    }
+
+    /* Fill the hole with the last entry, which may need to go either way */
+    moved = h[last];
+    rate_heap_set(est, heap, pos, moved);
+    rate_sift_up(est, heap, pos);
+    rate_sift_down(est, heap, est->slot_pos[moved]);
+}
+
+/*!
+ * @brief Restore lower_count == upper_count or upper_count + 1.
+ */
+static void rate_rebalance(PeakRateEstimatorFP *est)
+{
+    int32_t slot;
+
+    if (est->lower_count > (est->upper_count + 1)) {
+        slot = est->lower[0];
+        rate_heap_remove(est, RATE_LOWER, 0);
+        rate_heap_push(est, RATE_UPPER, slot);
+    } else if (est->upper_count > est->lower_count) {
+        slot = est->upper[0];
+        rate_heap_remove(est, RATE_UPPER, 0);
+        rate_heap_push(est, RATE_LOWER, slot);
+    } else {
+        /* Balanced */
+    }
+}
+
+/*!
+ * @brief Initialise an estimator.
+ *
+ * @param est Estimator state (caller-owned)
+ * @param config Window, rate unit and outlier settings (copied)
+ * @return PEAK_FP_OK on success, error code otherwise
+ */
+PeakResultFP peak_rate_init(PeakRateEstimatorFP *est, const PeakRateConfigFP *config)
+{
+    if ((est == NULL) || (config == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if ((config->window < 1) || (config->window > PEAK_RATE_WINDOW_MAX) ||
+        (config->samples_per_unit <= 0) || (config->outlier_tolerance_q16 < 0) ||
+        (config->outlier_min_count < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    est->config = *config;
+    est->head = 0;
+    est->count = 0;
+    est->lower_count = 0;
+    est->upper_count = 0;
+    est->last_index = 0;
+    est->have_last = false;
+
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Median of the intervals in the window.
+ *
+ * @param est Estimator state
+ * @param median_q16 Output: median interval (Q16.16 samples); the mean of
+ *        the two middle intervals for an even count
+ * @return PEAK_FP_OK, or PEAK_FP_NO_PEAK_FOUND before the first interval
+ */
+PeakResultFP peak_rate_median_q16(const PeakRateEstimatorFP *est, int32_t *median_q16)
+{
+    int64_t sum;
+
+    if ((est == NULL) || (median_q16 == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if (est->count == 0) {
+        return PEAK_FP_NO_PEAK_FOUND;
+    }
+
+    if (est->lower_count > est->upper_count) {
+        *median_q16 = est->intervals[est->lower[0]] * (int32_t)Q16_ONE;
+    } else {
+        sum = (int64_t)est->intervals[est->lower[0]] + (int64_t)est->intervals[est->upper[0]];
+        *median_q16 = (int32_t)((sum * Q16_ONE) / 2);
+    }
+
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Feed the stream index of the next peak.
+ *
+ * The interval to the previous peak replaces the oldest one in the
+ * window (O(log N)). It is flagged as an outlier when it differs from
+ * the median before the update by more than outlier_tolerance_q16 times
+ * that median; outliers still enter the window, where the median
+ * absorbs them.
+ *
+ * Intervals are taken modulo 2^31 (PEAK_STREAM_INDEX_MASK), so stream
+ * indices may wrap. An interval longer than PEAK_RATE_INTERVAL_MAX (a
+ * signal dropout, or an index that went backwards) is out of range: it
+ * is reported in out->interval with the outlier flag but does not enter
+ * the window, and the next interval is measured from this peak.
+ *
+ * @param est Estimator state
+ * @param peak_index Stream index of the peak (increasing modulo 2^31)
+ * @param out Output: interval, median, rate and outlier flag (only
+ *        interval and outlier for an out-of-range interval)
+ * @return PEAK_FP_OK, PEAK_FP_BUFFER_TOO_SMALL for the first peak (no
+ *         interval yet), PEAK_FP_INVALID_INPUT for a repeated index or
+ *         an out-of-range interval
+ */
+PeakResultFP peak_rate_push(PeakRateEstimatorFP *est, int32_t peak_index, PeakRateFP *out)
+{
+    int32_t interval;
+    int32_t slot;
+    int32_t median_q16;
+    int64_t rate;
+
+    if ((est == NULL) || (out == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if (!est->have_last) {
+        est->last_index = peak_index;
+        est->have_last = true;
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+
+    interval = (int32_t)(((uint32_t)peak_index - (uint32_t)est->last_index) &
+                         PEAK_STREAM_INDEX_MASK);
+    if (interval == 0) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+    est->last_index = peak_index;
+
+    if (interval > PEAK_RATE_INTERVAL_MAX) {
+        out->interval = interval;
+        out->outlier = true;
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    /* Outlier test against the median before this interval */
+    out->outlier = false;
+    if ((est->count >= est->config.outlier_min_count) &&
+        (peak_rate_median_q16(est, &median_q16) == PEAK_FP_OK)) {
+        int64_t deviation = ((int64_t)interval * Q16_ONE) - median_q16;
+        int64_t allowed = ((int64_t)est->config.outlier_tolerance_q16 * median_q16) >> 16;
+
+        deviation = (deviation < 0) ? -deviation : deviation;
+        out->outlier = (deviation > allowed);
+    }
+
+    /* Ring: reuse the oldest slot once the window is full */
+    if (est->count == est->config.window) {
+        slot = est->head;
+        rate_heap_remove(est, est->slot_heap[slot], est->slot_pos[slot]);
+        rate_rebalance(est);
+        est->head = (est->head + 1) % est->config.window;
+    } else {
+        slot = (est->head + est->count) % est->config.window;
+        est->count++;
+    }
+
+    est->intervals[slot] = interval;
+    if ((est->lower_count == 0) || (interval <= est->intervals[est->lower[0]])) {
+        rate_heap_push(est, RATE_LOWER, slot);
+    } else {
+        rate_heap_push(est, RATE_UPPER, slot);
+    }
+    rate_rebalance(est);
+
+    (void)peak_rate_median_q16(est, &median_q16);
+    rate = (((int64_t)est->config.samples_per_unit * Q16_ONE) * Q16_ONE) / median_q16;
+
+    out->interval = interval;
+    out->median_interval_q16 = median_q16;
+    out->rate_q16 = (rate > INT32_MAX) ? INT32_MAX : (int32_t)rate;
+
+    return PEAK_FP_OK;
+}
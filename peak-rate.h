@@ -0,0 +1,79 @@
+/*!
+ * Peak-to-Peak Interval and Rate Estimation
+ *
+ * Turns the peak indices of a streaming channel (peak_stream_next(),
+ * peak_pingpong_process(), sliding windows) into inter-peak intervals
+ * and a robust rate: heart rate in BPM, shaft speed in RPM, and so on.
+ *
+ * The last N intervals are kept in a fixed ring. Their running median
+ * comes from two indexed heaps (max-heap of the lower half, min-heap of
+ * the upper half); every ring slot knows its heap position, so the
+ * interval leaving the ring is removed in O(log N) without a search.
+ * Intervals far from the median are flagged as outliers (missed or
+ * spurious beats). Integer and Q16.16 arithmetic only; no allocation.
+ */
+
+#ifndef PEAK_RATE_H
+#define PEAK_RATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "embedded-signal-peaks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest supported median window (intervals) */
+#ifndef PEAK_RATE_WINDOW_MAX
+#define PEAK_RATE_WINDOW_MAX (32)
+#endif
+
+/* Longest interval (samples) whose Q16.16 median fits int32_t */
+#define PEAK_RATE_INTERVAL_MAX (32767)
+
+/* Estimator configuration */
+typedef struct {
+    int32_t window;                  /* Intervals in the median (1 .. PEAK_RATE_WINDOW_MAX) */
+    int32_t samples_per_unit;        /* Rate unit in samples, e.g. 60 * fs for per-minute */
+    int32_t outlier_tolerance_q16;   /* Allowed |interval - median| / median (Q16.16) */
+    int32_t outlier_min_count;       /* Intervals needed before flagging outliers */
+} PeakRateConfigFP;
+
+/* Result of one peak */
+typedef struct {
+    int32_t interval;                /* Samples since the previous peak */
+    int32_t median_interval_q16;     /* Median of the window (Q16.16 samples) */
+    int32_t rate_q16;                /* samples_per_unit / median (Q16.16) */
+    bool outlier;                    /* Interval outside the tolerance band */
+} PeakRateFP;
+
+/*!
+ * Estimator state. Treat the fields as private.
+ */
+typedef struct {
+    PeakRateConfigFP config;
+    int32_t intervals[PEAK_RATE_WINDOW_MAX];  /* Ring of recent intervals */
+    int32_t head;                             /* Oldest slot */
+    int32_t count;
+    int16_t lower[PEAK_RATE_WINDOW_MAX];      /* Max-heap of slots (lower half) */
+    int16_t upper[PEAK_RATE_WINDOW_MAX];      /* Min-heap of slots (upper half) */
+    int32_t lower_count;
+    int32_t upper_count;
+    int16_t slot_heap[PEAK_RATE_WINDOW_MAX];  /* 0 = lower, 1 = upper */
+    int16_t slot_pos[PEAK_RATE_WINDOW_MAX];   /* Position in that heap */
+    int32_t last_index;                       /* Stream index of the previous peak */
+    bool have_last;
+} PeakRateEstimatorFP;
+
+PeakResultFP peak_rate_init(PeakRateEstimatorFP *est, const PeakRateConfigFP *config);
+
+PeakResultFP peak_rate_push(PeakRateEstimatorFP *est, int32_t peak_index, PeakRateFP *out);
+
+PeakResultFP peak_rate_median_q16(const PeakRateEstimatorFP *est, int32_t *median_q16);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEAK_RATE_H */
@@ -0,0 +1,96 @@
+/*!
+ * peak-telemetry-cli - print live detector rates from a stats page
+ *
+ * Attaches read-only to the shared-memory page published by detector
+ * processes (see peak-telemetry.h) and prints, once per interval, the
+ * frame and peak rates, skip and reject percentages and
+ * latency percentiles over that interval.
+ *
+ * Build: gcc -std=c11 -O2 -o peak-telemetry-cli peak-telemetry-cli.c \
+ *            peak-telemetry.c embedded-signal-peaks.c
+ * Usage: peak-telemetry-cli <shm-name> [interval_ms] [count]
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "peak-telemetry.h"
+
+static PeakTelemetrySnapshot s_prev;
+static PeakTelemetrySnapshot s_curr;
+static uint64_t s_delta_hist[PEAK_TELEMETRY_HIST_BUCKETS];
+
+static double percent(uint64_t part, uint64_t whole)
+{
+    return (whole > 0U) ? ((100.0 * (double)part) / (double)whole) : 0.0;
+}
+
+int main(int argc, char *argv[])
+{
+    PeakTelemetryPage *page;
+    long interval_ms = 1000;
+    long count = 0;
+    long n;
+    struct timespec delay;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <shm-name> [interval_ms] [count]\n", argv[0]);
+        return 2;
+    }
+    if (argc > 2) {
+        interval_ms = strtol(argv[2], NULL, 10);
+        interval_ms = (interval_ms > 0) ? interval_ms : 1000;
+    }
+    if (argc > 3) {
+        count = strtol(argv[3], NULL, 10);
+    }
+
+    page = peak_telemetry_open(argv[1], false);
+    if (page == NULL) {
+        fprintf(stderr, "%s: cannot attach to stats page '%s'\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    delay.tv_sec = interval_ms / 1000;
+    delay.tv_nsec = (interval_ms % 1000) * 1000000L;
+
+    printf("%10s %10s %8s %9s %10s %10s %10s %10s\n",
+           "frames/s", "peaks/s", "skip%", "reject%", "p50_ns", "p99_ns", "p999_ns", "max_ns");
+
+    peak_telemetry_snapshot(page, &s_prev);
+
+    for (n = 0; (count <= 0) || (n < count); n++) {
+        double seconds = (double)interval_ms / 1000.0;
+        uint64_t frames;
+        uint32_t b;
+
+        (void)nanosleep(&delay, NULL);
+        peak_telemetry_snapshot(page, &s_curr);
+
+        frames = s_curr.frames - s_prev.frames;
+        for (b = 0U; b < PEAK_TELEMETRY_HIST_BUCKETS; b++) {
+            s_delta_hist[b] = s_curr.latency_hist[b] - s_prev.latency_hist[b];
+        }
+
+        printf("%10.0f %10.0f %8.2f %9.2f %10llu %10llu %10llu %10llu\n",
+               (double)frames / seconds,
+               (double)(s_curr.frames_with_peak - s_prev.frames_with_peak) / seconds,
+               percent(s_curr.frames_skipped - s_prev.frames_skipped,
+                       frames + (s_curr.frames_skipped - s_prev.frames_skipped)),
+               percent(s_curr.frames_rejected - s_prev.frames_rejected, frames),
+               (unsigned long long)peak_telemetry_percentile(s_delta_hist, 500U),
+               (unsigned long long)peak_telemetry_percentile(s_delta_hist, 990U),
+               (unsigned long long)peak_telemetry_percentile(s_delta_hist, 999U),
+               (unsigned long long)s_curr.latency_max_ns);
+        fflush(stdout);
+
+        s_prev = s_curr;
+    }
+
+    peak_telemetry_close(page);
+
+    return 0;
+}
@@ -0,0 +1,400 @@
+/*!
+ * Detector Telemetry - Shared-Memory Stats Page
+ *
+ * Writers: one slot per detector thread, relaxed load/store only.
+ * Readers: any process mapping the page; values are read relaxed and
+ * may be a few frames apart from each other, which is fine for rates.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "peak-telemetry.h"
+
+/* Lock-freedom of atomic_uint_least64_t: the macro of the type it is */
+#if UINT_LEAST64_MAX == ULONG_MAX
+#define TELEMETRY_U64_LOCK_FREE ATOMIC_LONG_LOCK_FREE
+#else
+#define TELEMETRY_U64_LOCK_FREE ATOMIC_LLONG_LOCK_FREE
+#endif
+
+_Static_assert(TELEMETRY_U64_LOCK_FREE == 2,
+               "telemetry page needs lock-free atomic_uint_least64_t");
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2,
+               "telemetry page needs lock-free atomic_uint");
+
+/* How long a writer attaching to a fresh page waits for its creator to
+ * publish the header before initialising it itself (1 ms steps) */
+#define TELEMETRY_ATTACH_WAIT_MS (100)
+
+/* Number of power-of-two octaves covered by the histogram */
+#define TELEMETRY_SUB_COUNT (1U << PEAK_TELEMETRY_SUB_BITS)
+
+/*!
+ * @brief Add to a counter owned by the calling thread.
+ *
+ * Only one thread writes a slot, so a relaxed load + store is enough and
+ * avoids the locked read-modify-write of atomic_fetch_add.
+ */
+static inline void slot_add(atomic_uint_least64_t *counter, uint64_t n)
+{
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + n,
+                          memory_order_relaxed);
+}
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+/*!
+ * @brief Histogram bucket of a latency value.
+ *
+ * Values below 2^SUB_BITS map linearly; above, each power of two is
+ * split into 2^SUB_BITS equal sub-buckets.
+ */
+uint32_t peak_telemetry_bucket(uint64_t latency_ns)
+{
+    uint32_t msb;
+    uint32_t bucket;
+
+    if (latency_ns < TELEMETRY_SUB_COUNT) {
+        return (uint32_t)latency_ns;
+    }
+
+    msb = 63U - (uint32_t)__builtin_clzll(latency_ns);
+    bucket = ((msb - PEAK_TELEMETRY_SUB_BITS + 1U) * TELEMETRY_SUB_COUNT) +
+             (uint32_t)((latency_ns >> (msb - PEAK_TELEMETRY_SUB_BITS)) &
+                        (TELEMETRY_SUB_COUNT - 1U));
+
+    return (bucket < PEAK_TELEMETRY_HIST_BUCKETS) ? bucket : (PEAK_TELEMETRY_HIST_BUCKETS - 1U);
+}
+
+/*!
+ * @brief Smallest latency that falls into a bucket.
+ */
+uint64_t peak_telemetry_bucket_floor(uint32_t bucket)
+{
+    uint32_t octave;
+    uint64_t sub;
+
+    if (bucket < TELEMETRY_SUB_COUNT) {
+        return bucket;
+    }
+
+    octave = (bucket / TELEMETRY_SUB_COUNT) - 1U;
+    sub = (uint64_t)(bucket % TELEMETRY_SUB_COUNT);
+
+    return (TELEMETRY_SUB_COUNT + sub) << octave;
+}
+
+/*!
+ * @brief Latency percentile from a histogram.
+ *
+ * @param hist Histogram (PEAK_TELEMETRY_HIST_BUCKETS counts)
+ * @param per_mille Percentile in 1/1000 (500 = median, 999 = p99.9)
+ * @return Lower bound of the bucket holding the percentile (0 if empty)
+ */
+uint64_t peak_telemetry_percentile(const uint64_t hist[], uint32_t per_mille)
+{
+    uint64_t total = 0U;
+    uint64_t rank;
+    uint64_t seen = 0U;
+    uint32_t b;
+
+    for (b = 0U; b < PEAK_TELEMETRY_HIST_BUCKETS; b++) {
+        total += hist[b];
+    }
+
+    if (total == 0U) {
+        return 0U;
+    }
+
+    rank = ((total * per_mille) + 999U) / 1000U;
+    rank = (rank == 0U) ? 1U : rank;
+
+    for (b = 0U; b < PEAK_TELEMETRY_HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= rank) {
+            break;
+        }
+    }
+
+    return peak_telemetry_bucket_floor((b < PEAK_TELEMETRY_HIST_BUCKETS) ? b :
+                                       (PEAK_TELEMETRY_HIST_BUCKETS - 1U));
+}
+
+/*!
+ * @brief Initialise a page in ordinary (process-local) memory.
+ */
+void peak_telemetry_init(PeakTelemetryPage *page)
+{
+    if (page == NULL) {
+        return;
+    }
+
+    memset(page, 0, sizeof(*page));
+    page->version = PEAK_TELEMETRY_VERSION;
+    page->max_slots = PEAK_TELEMETRY_MAX_SLOTS;
+    atomic_init(&page->slots_claimed, 0U);
+    atomic_store_explicit(&page->magic, PEAK_TELEMETRY_MAGIC, memory_order_release);
+}
+
+/*!
+ * @brief True once a page carries this build's header.
+ *
+ * The magic is loaded with acquire, pairing with the release store in
+ * peak_telemetry_init(), before the rest of the header is trusted.
+ */
+static bool telemetry_header_valid(const PeakTelemetryPage *page)
+{
+    return (atomic_load_explicit(&page->magic, memory_order_acquire) == PEAK_TELEMETRY_MAGIC) &&
+           (page->version == PEAK_TELEMETRY_VERSION) &&
+           (page->max_slots == PEAK_TELEMETRY_MAX_SLOTS);
+}
+
+/*!
+ * @brief Writer attaching to a page another process created.
+ *
+ * Waits briefly for the creator to publish the header. A page that is
+ * still unpublished after that, or carries another version, is stale
+ * (its creator died, or an older build left it) and is initialised.
+ */
+static void telemetry_attach_writer(PeakTelemetryPage *page)
+{
+    struct timespec step = { 0, 1000000L };
+    int32_t waited;
+
+    for (waited = 0; waited < TELEMETRY_ATTACH_WAIT_MS; waited++) {
+        if (telemetry_header_valid(page)) {
+            return;
+        }
+        if (atomic_load_explicit(&page->magic, memory_order_relaxed) != 0U) {
+            break;  /* Published by another build */
+        }
+        (void)nanosleep(&step, NULL);
+    }
+
+    if (!telemetry_header_valid(page)) {
+        peak_telemetry_init(page);
+    }
+}
+
+/*!
+ * @brief Map a named shared-memory page.
+ *
+ * Writers create the page exclusively. When it already exists they
+ * attach to it and keep its counters and claimed slots, so a second or
+ * restarted detector process never wipes live slots; each writer thread
+ * still claims a slot of its own.
+ *
+ * @param name POSIX shm name (e.g. "/peaks")
+ * @param create true in detector processes (creates and initialises the
+ *        page, or attaches read-write to an existing one), false in
+ *        readers (attaches read-only, validates the header)
+ * @return Mapped page, or NULL on failure
+ */
+PeakTelemetryPage *peak_telemetry_open(const char *name, bool create)
+{
+    PeakTelemetryPage *page;
+    struct stat st;
+    bool created = false;
+    int fd;
+    void *mem;
+
+    if (name == NULL) {
+        return NULL;
+    }
+
+    if (create) {
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+        created = (fd >= 0);
+        if ((fd < 0) && (errno == EEXIST)) {
+            fd = shm_open(name, O_RDWR, 0644);
+        }
+    } else {
+        fd = shm_open(name, O_RDONLY, 0644);
+    }
+    if (fd < 0) {
+        return NULL;
+    }
+
+    /* A page caught between its creator's shm_open and ftruncate is too
+     * short to map; writers size it themselves (same size, so harmless) */
+    if (fstat(fd, &st) != 0) {
+        (void)close(fd);
+        return NULL;
+    }
+    if ((st.st_size < (off_t)sizeof(PeakTelemetryPage)) &&
+        (!create || (ftruncate(fd, (off_t)sizeof(PeakTelemetryPage)) != 0))) {
+        (void)close(fd);
+        return NULL;
+    }
+
+    mem = mmap(NULL, sizeof(PeakTelemetryPage),
+               create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+    (void)close(fd);
+
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+
+    page = (PeakTelemetryPage *)mem;
+
+    if (created) {
+        peak_telemetry_init(page);
+    } else if (create) {
+        telemetry_attach_writer(page);
+    } else if (!telemetry_header_valid(page)) {
+        (void)munmap(mem, sizeof(PeakTelemetryPage));
+        page = NULL;
+    } else {
+        /* Valid page */
+    }
+
+    return page;
+}
+
+/*!
+ * @brief Unmap a page returned by peak_telemetry_open().
+ */
+void peak_telemetry_close(PeakTelemetryPage *page)
+{
+    if (page != NULL) {
+        (void)munmap(page, sizeof(PeakTelemetryPage));
+    }
+}
+
+/*!
+ * @brief Claim a slot for the calling detector thread.
+ *
+ * @return Slot owned by the caller, or NULL when all slots are taken
+ */
+PeakTelemetrySlot *peak_telemetry_claim_slot(PeakTelemetryPage *page)
+{
+    unsigned int index;
+
+    if (page == NULL) {
+        return NULL;
+    }
+
+    index = atomic_fetch_add_explicit(&page->slots_claimed, 1U, memory_order_relaxed);
+    if (index >= PEAK_TELEMETRY_MAX_SLOTS) {
+        return NULL;
+    }
+
+    return &page->slots[index];
+}
+
+/*!
+ * @brief Record one processed frame.
+ *
+ * @param slot Slot owned by the calling thread
+ * @param result Detector result for the frame
+ * @param latency_ns Detection latency
+ */
+void peak_telemetry_record(PeakTelemetrySlot *slot,
+                           PeakResultFP result,
+                           uint64_t latency_ns)
+{
+    if (slot == NULL) {
+        return;
+    }
+
+    slot_add(&slot->frames, 1U);
+    if (result == PEAK_FP_OK) {
+        slot_add(&slot->frames_with_peak, 1U);
+    }
+    if ((result == PEAK_FP_INVALID_INPUT) || (result == PEAK_FP_BUFFER_TOO_SMALL)) {
+        slot_add(&slot->frames_rejected, 1U);
+    }
+    slot_add(&slot->latency_sum_ns, latency_ns);
+    if (latency_ns > atomic_load_explicit(&slot->latency_max_ns, memory_order_relaxed)) {
+        atomic_store_explicit(&slot->latency_max_ns, latency_ns, memory_order_relaxed);
+    }
+    slot_add(&slot->latency_hist[peak_telemetry_bucket(latency_ns)], 1U);
+}
+
+/*!
+ * @brief Record a frame the application dropped without detection.
+ */
+void peak_telemetry_record_skip(PeakTelemetrySlot *slot)
+{
+    if (slot != NULL) {
+        slot_add(&slot->frames_skipped, 1U);
+    }
+}
+
+/*!
+ * @brief find_prominent_peak_fp() with timing recorded into a slot.
+ */
+PeakResultFP peak_telemetry_detect(PeakTelemetrySlot *slot,
+                                   const int16_t signal[],
+                                   int32_t length,
+                                   int32_t *peak_index,
+                                   const PeakConfigFP *user_config)
+{
+    uint64_t t0 = monotonic_ns();
+    PeakResultFP result = find_prominent_peak_fp(signal, length, peak_index, user_config);
+    uint64_t latency = monotonic_ns() - t0;
+
+    peak_telemetry_record(slot, result, latency);
+
+    return result;
+}
+
+/*!
+ * @brief Sum the counters of all claimed slots.
+ */
+void peak_telemetry_snapshot(const PeakTelemetryPage *page,
+                             PeakTelemetrySnapshot *snapshot)
+{
+    unsigned int claimed;
+    unsigned int s;
+    uint32_t b;
+
+    if ((page == NULL) || (snapshot == NULL)) {
+        return;
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    claimed = atomic_load_explicit(&page->slots_claimed, memory_order_relaxed);
+    claimed = (claimed > PEAK_TELEMETRY_MAX_SLOTS) ? PEAK_TELEMETRY_MAX_SLOTS : claimed;
+
+    for (s = 0U; s < claimed; s++) {
+        const PeakTelemetrySlot *slot = &page->slots[s];
+        uint64_t max_ns = atomic_load_explicit(&slot->latency_max_ns, memory_order_relaxed);
+
+        snapshot->frames += atomic_load_explicit(&slot->frames, memory_order_relaxed);
+        snapshot->frames_with_peak += atomic_load_explicit(&slot->frames_with_peak,
+                                                           memory_order_relaxed);
+        snapshot->frames_skipped += atomic_load_explicit(&slot->frames_skipped,
+                                                         memory_order_relaxed);
+        snapshot->frames_rejected += atomic_load_explicit(&slot->frames_rejected,
+                                                          memory_order_relaxed);
+        snapshot->latency_sum_ns += atomic_load_explicit(&slot->latency_sum_ns,
+                                                         memory_order_relaxed);
+        snapshot->latency_max_ns = (max_ns > snapshot->latency_max_ns) ?
+                                   max_ns : snapshot->latency_max_ns;
+
+        for (b = 0U; b < PEAK_TELEMETRY_HIST_BUCKETS; b++) {
+            snapshot->latency_hist[b] += atomic_load_explicit(&slot->latency_hist[b],
+                                                              memory_order_relaxed);
+        }
+    }
+}
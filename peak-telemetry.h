@@ -0,0 +1,108 @@
+/*!
+ * Detector Telemetry - Shared-Memory Stats Page
+ *
+ * Live counters and latency histograms for host-side detector threads,
+ * published into a POSIX shared-memory page that a separate process
+ * (peak-telemetry-cli) can attach to without pausing the detectors.
+ *
+ * Each detector thread claims its own slot and is the only writer to
+ * it, so recording a frame is a handful of relaxed loads and stores: no
+ * locks, no read-modify-write instructions, no shared cache lines.
+ *
+ * Requires C11 <stdatomic.h> with lock-free 64-bit atomics (host only).
+ */
+
+#ifndef PEAK_TELEMETRY_H
+#define PEAK_TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "embedded-signal-peaks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PEAK_TELEMETRY_MAGIC (0x504B544DU)  /* "PKTM" */
+#define PEAK_TELEMETRY_VERSION (2U)
+
+/* Detector slots per page (one per writer thread) */
+#ifndef PEAK_TELEMETRY_MAX_SLOTS
+#define PEAK_TELEMETRY_MAX_SLOTS (64)
+#endif
+
+/*
+ * HDR-style latency histogram: 4 linear sub-buckets per power of two,
+ * covering 0 ns to ~8 s with <= 25% relative bucket width.
+ */
+#define PEAK_TELEMETRY_SUB_BITS (2)
+#define PEAK_TELEMETRY_HIST_BUCKETS (128)
+
+#define PEAK_TELEMETRY_CACHE_LINE (64)
+
+/* Per-thread counters; cache-line aligned so writers never share a line */
+typedef struct {
+    _Alignas(PEAK_TELEMETRY_CACHE_LINE) atomic_uint_least64_t frames;
+    atomic_uint_least64_t frames_with_peak;
+    atomic_uint_least64_t frames_skipped;
+    atomic_uint_least64_t frames_rejected;  /* Invalid input or too long for the detector */
+    atomic_uint_least64_t latency_sum_ns;
+    atomic_uint_least64_t latency_max_ns;
+    atomic_uint_least64_t latency_hist[PEAK_TELEMETRY_HIST_BUCKETS];
+} PeakTelemetrySlot;
+
+/* Shared page layout */
+typedef struct {
+    _Alignas(PEAK_TELEMETRY_CACHE_LINE) atomic_uint magic;  /* Published last (release) */
+    uint32_t version;
+    uint32_t max_slots;
+    atomic_uint slots_claimed;
+    PeakTelemetrySlot slots[PEAK_TELEMETRY_MAX_SLOTS];
+} PeakTelemetryPage;
+
+/* Aggregate over all claimed slots (reader side) */
+typedef struct {
+    uint64_t frames;
+    uint64_t frames_with_peak;
+    uint64_t frames_skipped;
+    uint64_t frames_rejected;
+    uint64_t latency_sum_ns;
+    uint64_t latency_max_ns;
+    uint64_t latency_hist[PEAK_TELEMETRY_HIST_BUCKETS];
+} PeakTelemetrySnapshot;
+
+void peak_telemetry_init(PeakTelemetryPage *page);
+
+PeakTelemetryPage *peak_telemetry_open(const char *name, bool create);
+
+void peak_telemetry_close(PeakTelemetryPage *page);
+
+PeakTelemetrySlot *peak_telemetry_claim_slot(PeakTelemetryPage *page);
+
+void peak_telemetry_record(PeakTelemetrySlot *slot,
+                           PeakResultFP result,
+                           uint64_t latency_ns);
+
+void peak_telemetry_record_skip(PeakTelemetrySlot *slot);
+
+PeakResultFP peak_telemetry_detect(PeakTelemetrySlot *slot,
+                                   const int16_t signal[],
+                                   int32_t length,
+                                   int32_t *peak_index,
+                                   const PeakConfigFP *user_config);
+
+void peak_telemetry_snapshot(const PeakTelemetryPage *page,
+                             PeakTelemetrySnapshot *snapshot);
+
+uint32_t peak_telemetry_bucket(uint64_t latency_ns);
+
+uint64_t peak_telemetry_bucket_floor(uint32_t bucket);
+
+uint64_t peak_telemetry_percentile(const uint64_t hist[], uint32_t per_mille);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEAK_TELEMETRY_H */
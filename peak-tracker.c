@@ -0,0 +1,367 @@
+/*!
+ * Frame-to-Frame Peak Tracking
+ *
+ * Sorting is an in-place heapsort of int16 element numbers by int64
+ * keys. Every key is value * 65536 + element number, so keys are unique
+ * and ties resolve to the lower track slot, peak or pair, which keeps
+ * the association deterministic.
+ */
+
+#include <stddef.h>
+#include "peak-tracker.h"
+
+/* Room for the element number in a sort key */
+#define TRACK_KEY_SCALE ((int64_t)1 << 16)
+
+/*!
+ * @brief Clamp an int64 to the int32 range.
+ */
+static inline int32_t track_saturate(int64_t value)
+{
+    if (value > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (value < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)value;
+}
+
+static void track_sift_down(int16_t order[], const int64_t keys[], int32_t pos, int32_t n)
+{
+    int32_t element = order[pos];
+
+    for (;;) {
+        int32_t child = (2 * pos) + 1;
+
+        if (child >= n) {
+            break;
+        }
+        if (((child + 1) < n) && (keys[order[child + 1]] > keys[order[child]])) {
+            child++;
+        }
+        if (keys[order[child]] <= keys[element]) {
+            break;
+        }
+        order[pos] = order[child];
+        pos = child;
+    }
+    order[pos] = (int16_t)element;
+}
+
+/*!
+ * @brief Sort element numbers ascending by key (heapsort, O(n log n)).
+ */
+static void track_sort(int16_t order[], const int64_t keys[], int32_t n)
+{
+    int32_t i;
+    int32_t end;
+
+    for (i = (n / 2) - 1; i >= 0; i--) {
+        track_sift_down(order, keys, i, n);
+    }
+    for (end = n - 1; end > 0; end--) {
+        int16_t top = order[0];
+
+        order[0] = order[end];
+        order[end] = top;
+        track_sift_down(order, keys, 0, end);
+    }
+}
+
+/*!
+ * @brief Initialise a tracker with an empty track pool.
+ *
+ * @param tracker Tracker state (caller-owned)
+ * @param config Gate, filter gains and miss limit (copied)
+ * @return PEAK_FP_OK on success, error code otherwise
+ */
+PeakResultFP peak_tracker_init(PeakTrackerFP *tracker, const PeakTrackerConfigFP *config)
+{
+    int32_t slot;
+
+    if ((tracker == NULL) || (config == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if ((config->gate_q16 <= 0) || (config->alpha_q16 <= 0) ||
+        (config->alpha_q16 > (int32_t)Q16_ONE) || (config->beta_q16 < 0) ||
+        (config->beta_q16 > (int32_t)Q16_ONE) || (config->max_misses < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    tracker->config = *config;
+    tracker->next_id = 0;
+    tracker->pairs_dropped = 0;
+    for (slot = 0; slot < PEAK_TRACK_MAX; slot++) {
+        tracker->tracks[slot].active = false;
+    }
+
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Predict every active track and sort the predictions.
+ *
+ * @return Number of active tracks
+ */
+static int32_t track_predict(PeakTrackerFP *tracker)
+{
+    int32_t count = 0;
+    int32_t slot;
+
+    for (slot = 0; slot < PEAK_TRACK_MAX; slot++) {
+        const PeakTrackFP *track = &tracker->tracks[slot];
+
+        tracker->track_peak[slot] = PEAK_TRACK_NONE;
+        if (!track->active) {
+            continue;
+        }
+        tracker->predicted_q16[slot] =
+            track_saturate((int64_t)track->position_q16 + track->velocity_q16);
+        tracker->keys[slot] = ((int64_t)tracker->predicted_q16[slot] * TRACK_KEY_SCALE) + slot;
+        tracker->track_order[count] = (int16_t)slot;
+        count++;
+    }
+
+    track_sort(tracker->track_order, tracker->keys, count);
+    return count;
+}
+
+/*!
+ * @brief Collect the gated (track, peak) pairs with one sweep.
+ *
+ * Predictions and peaks are both sorted, so the peaks inside a track's
+ * gate form a run whose start only moves forward.
+ *
+ * Pairs past PEAK_TRACK_PAIRS_MAX (those of the tracks predicted
+ * furthest right) are counted in pairs_dropped but not stored.
+ *
+ * @return Number of pairs (at most PEAK_TRACK_PAIRS_MAX)
+ */
+static int32_t track_gate(PeakTrackerFP *tracker, const PeakInfoFP peaks[],
+                          int32_t num_tracks, int32_t num_peaks)
+{
+    int32_t first = 0;
+    int32_t count = 0;
+    int32_t t;
+    int32_t p;
+
+    tracker->pairs_dropped = 0;
+    for (t = 0; t < num_tracks; t++) {
+        int32_t slot = tracker->track_order[t];
+        int64_t predicted = tracker->predicted_q16[slot];
+
+        while ((first < num_peaks) &&
+               ((((int64_t)peaks[tracker->peak_order[first]].index * Q16_ONE) - predicted) <
+                -(int64_t)tracker->config.gate_q16)) {
+            first++;
+        }
+
+        for (p = first; p < num_peaks; p++) {
+            int32_t peak = tracker->peak_order[p];
+            int64_t distance = ((int64_t)peaks[peak].index * Q16_ONE) - predicted;
+
+            if (distance > tracker->config.gate_q16) {
+                break;
+            }
+            if (count == PEAK_TRACK_PAIRS_MAX) {
+                tracker->pairs_dropped++;
+                continue;
+            }
+            distance = (distance < 0) ? -distance : distance;
+            tracker->pair_track[count] = (int16_t)slot;
+            tracker->pair_peak[count] = (int16_t)peak;
+            tracker->keys[count] = (distance * TRACK_KEY_SCALE) + count;
+            tracker->pair_order[count] = (int16_t)count;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/*!
+ * @brief Start a track on a peak in the lowest free slot.
+ *
+ * @return The new track id, or PEAK_TRACK_NONE if the pool is full
+ */
+static int32_t track_birth(PeakTrackerFP *tracker, const PeakInfoFP *peak)
+{
+    int32_t slot;
+
+    for (slot = 0; slot < PEAK_TRACK_MAX; slot++) {
+        PeakTrackFP *track = &tracker->tracks[slot];
+
+        if (!track->active) {
+            track->id = tracker->next_id;
+            track->position_q16 = peak->index * (int32_t)Q16_ONE;
+            track->velocity_q16 = 0;
+            track->prominence_q16 = peak->prominence_q16;
+            track->age = 0;
+            track->misses = 0;
+            track->active = true;
+            tracker->next_id++;
+            return track->id;
+        }
+    }
+
+    return PEAK_TRACK_NONE;
+}
+
+/*!
+ * @brief Feed the peaks of the next frame.
+ *
+ * Active tracks are predicted one frame ahead and matched to peaks
+ * within gate_q16, nearest pair first; each track and each peak is used
+ * at most once. Matched tracks get the alpha-beta correction, unmatched
+ * ones coast on their velocity and end after max_misses consecutive
+ * misses. Every unmatched peak starts a new track while the pool has
+ * room.
+ *
+ * At most PEAK_TRACK_PAIRS_MAX gated pairs are considered. When a wide
+ * gate yields more, the update still completes but the pairs of the
+ * tracks predicted furthest right are not considered: those tracks
+ * coast and their peaks may start new tracks. The number of dropped
+ * pairs is left in tracker->pairs_dropped (0 when none were).
+ *
+ * @param tracker Tracker state
+ * @param peaks Peaks of this frame, any order (indices 0..PEAK_TRACK_INDEX_MAX)
+ * @param num_peaks Number of peaks (0 .. PEAK_TRACK_PEAKS_MAX)
+ * @param track_ids Optional output, same order as peaks: track id of each
+ *        peak, or PEAK_TRACK_NONE when the pool was full (may be NULL)
+ * @return PEAK_FP_OK on success (also when pairs were dropped),
+ *         PEAK_FP_BUFFER_TOO_SMALL if num_peaks exceeds
+ *         PEAK_TRACK_PEAKS_MAX (nothing updated), PEAK_FP_INVALID_INPUT
+ *         otherwise
+ */
+PeakResultFP peak_tracker_update(PeakTrackerFP *tracker,
+                                 const PeakInfoFP peaks[],
+                                 int32_t num_peaks,
+                                 int32_t track_ids[])
+{
+    int32_t num_tracks;
+    int32_t num_pairs;
+    int32_t p;
+    int32_t k;
+    int32_t t;
+
+    if ((tracker == NULL) || (num_peaks < 0) || ((peaks == NULL) && (num_peaks > 0))) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if (num_peaks > PEAK_TRACK_PEAKS_MAX) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+
+    for (p = 0; p < num_peaks; p++) {
+        if ((peaks[p].index < 0) || (peaks[p].index > PEAK_TRACK_INDEX_MAX)) {
+            return PEAK_FP_INVALID_INPUT;
+        }
+    }
+
+    /* Sort peaks by index, then tracks by prediction */
+    for (p = 0; p < num_peaks; p++) {
+        tracker->keys[p] = ((int64_t)peaks[p].index * TRACK_KEY_SCALE) + p;
+        tracker->peak_order[p] = (int16_t)p;
+        tracker->peak_track[p] = PEAK_TRACK_NONE;
+    }
+    track_sort(tracker->peak_order, tracker->keys, num_peaks);
+    num_tracks = track_predict(tracker);
+
+    /* Gate, then accept pairs nearest first */
+    num_pairs = track_gate(tracker, peaks, num_tracks, num_peaks);
+    track_sort(tracker->pair_order, tracker->keys, num_pairs);
+    for (k = 0; k < num_pairs; k++) {
+        int32_t pair = tracker->pair_order[k];
+        int32_t slot = tracker->pair_track[pair];
+        int32_t peak = tracker->pair_peak[pair];
+
+        if ((tracker->track_peak[slot] == PEAK_TRACK_NONE) &&
+            (tracker->peak_track[peak] == PEAK_TRACK_NONE)) {
+            tracker->track_peak[slot] = (int16_t)peak;
+            tracker->peak_track[peak] = (int16_t)slot;
+        }
+    }
+
+    /* Correct or coast every active track */
+    for (t = 0; t < num_tracks; t++) {
+        int32_t slot = tracker->track_order[t];
+        PeakTrackFP *track = &tracker->tracks[slot];
+        int32_t predicted = tracker->predicted_q16[slot];
+        int32_t peak = tracker->track_peak[slot];
+
+        if (peak != PEAK_TRACK_NONE) {
+            int64_t residual = ((int64_t)peaks[peak].index * Q16_ONE) - predicted;
+
+            track->position_q16 = track_saturate(predicted +
+                                                 ((residual * tracker->config.alpha_q16) >> 16));
+            track->velocity_q16 = track_saturate(track->velocity_q16 +
+                                                 ((residual * tracker->config.beta_q16) >> 16));
+            track->prominence_q16 = peaks[peak].prominence_q16;
+            track->misses = 0;
+        } else {
+            track->position_q16 = predicted;
+            track->misses++;
+            if (track->misses > tracker->config.max_misses) {
+                track->active = false;
+                continue;
+            }
+        }
+        track->age++;
+    }
+
+    /* Births in index order, then report ids in input order */
+    for (p = 0; p < num_peaks; p++) {
+        int32_t peak = tracker->peak_order[p];
+        int32_t id;
+
+        if (tracker->peak_track[peak] != PEAK_TRACK_NONE) {
+            id = tracker->tracks[tracker->peak_track[peak]].id;
+        } else {
+            id = track_birth(tracker, &peaks[peak]);
+        }
+        if (track_ids != NULL) {
+            track_ids[peak] = id;
+        }
+    }
+
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Copy out the active tracks, in slot order.
+ *
+ * @param tracker Tracker state
+ * @param tracks Output array
+ * @param max_tracks Capacity of tracks
+ * @param num_tracks Output: number of tracks written
+ * @return PEAK_FP_OK, PEAK_FP_BUFFER_TOO_SMALL if some tracks did not fit
+ */
+PeakResultFP peak_tracker_tracks(const PeakTrackerFP *tracker,
+                                 PeakTrackFP tracks[],
+                                 int32_t max_tracks,
+                                 int32_t *num_tracks)
+{
+    int32_t count = 0;
+    int32_t slot;
+
+    if ((tracker == NULL) || (tracks == NULL) || (num_tracks == NULL) || (max_tracks < 0)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    for (slot = 0; slot < PEAK_TRACK_MAX; slot++) {
+        if (!tracker->tracks[slot].active) {
+            continue;
+        }
+        if (count == max_tracks) {
+            *num_tracks = count;
+            return PEAK_FP_BUFFER_TOO_SMALL;
+        }
+        tracks[count] = tracker->tracks[slot];
+        count++;
+    }
+
+    *num_tracks = count;
+    return PEAK_FP_OK;
+}
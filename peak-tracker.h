@@ -0,0 +1,105 @@
+/*!
+ * Frame-to-Frame Peak Tracking
+ *
+ * Gives the peaks of successive frames (spectral lines, repeated pulses)
+ * identities that persist across frames. Every track carries an
+ * alpha-beta filtered position and velocity; each frame the predicted
+ * positions and the new peaks are sorted, a single sweep collects the
+ * (track, peak) pairs inside the gate, and the pairs are accepted
+ * nearest first. Association is O(p log p) for p peaks and tracks when
+ * the gate is narrower than the line spacing.
+ *
+ * Unmatched peaks start tracks, tracks unmatched for more than
+ * max_misses frames end. The track pool and all scratch space live in
+ * the tracker struct; no allocation.
+ */
+
+#ifndef PEAK_TRACKER_H
+#define PEAK_TRACKER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "embedded-signal-peaks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Track pool size */
+#ifndef PEAK_TRACK_MAX
+#define PEAK_TRACK_MAX (32)
+#endif
+
+/* Largest peak count per frame */
+#ifndef PEAK_TRACK_PEAKS_MAX
+#define PEAK_TRACK_PEAKS_MAX (MAX_PEAKS)
+#endif
+
+/* Gated pairs considered per frame; past this peak_tracker_update()
+ * drops pairs and counts them in pairs_dropped */
+#ifndef PEAK_TRACK_PAIRS_MAX
+#define PEAK_TRACK_PAIRS_MAX (4 * PEAK_TRACK_MAX)
+#endif
+
+/* Largest peak index, so Q16.16 positions cannot overflow */
+#define PEAK_TRACK_INDEX_MAX (32767)
+
+/* No track for this peak (pool full) */
+#define PEAK_TRACK_NONE (-1)
+
+/* Tracker configuration */
+typedef struct {
+    int32_t gate_q16;        /* Largest |peak - predicted position| (Q16.16 samples) */
+    int32_t alpha_q16;       /* Position gain, (0, 1] (Q16.16) */
+    int32_t beta_q16;        /* Velocity gain, [0, 1] (Q16.16) */
+    int32_t max_misses;      /* Frames a track may coast without a peak */
+} PeakTrackerConfigFP;
+
+/* One track */
+typedef struct {
+    int32_t id;              /* Unique, increasing from 0 */
+    int32_t position_q16;    /* Filtered position (Q16.16 samples) */
+    int32_t velocity_q16;    /* Filtered velocity (Q16.16 samples per frame) */
+    int32_t prominence_q16;  /* Prominence of the last matched peak */
+    int32_t age;             /* Frames since birth */
+    int32_t misses;          /* Consecutive frames without a peak */
+    bool active;
+} PeakTrackFP;
+
+/*!
+ * Tracker state. Treat the fields as private, except pairs_dropped,
+ * which may be read after each update.
+ */
+typedef struct {
+    PeakTrackerConfigFP config;
+    PeakTrackFP tracks[PEAK_TRACK_MAX];
+    int32_t next_id;
+    int32_t pairs_dropped;                        /* Gated pairs dropped by the last update */
+    int16_t track_order[PEAK_TRACK_MAX];          /* Active slots by prediction */
+    int16_t peak_order[PEAK_TRACK_PEAKS_MAX];     /* Peaks by index */
+    int16_t pair_order[PEAK_TRACK_PAIRS_MAX];     /* Pairs by distance */
+    int16_t pair_track[PEAK_TRACK_PAIRS_MAX];
+    int16_t pair_peak[PEAK_TRACK_PAIRS_MAX];
+    int64_t keys[PEAK_TRACK_PAIRS_MAX + PEAK_TRACK_PEAKS_MAX];
+    int32_t predicted_q16[PEAK_TRACK_MAX];
+    int16_t track_peak[PEAK_TRACK_MAX];           /* Matched peak per slot */
+    int16_t peak_track[PEAK_TRACK_PEAKS_MAX];     /* Matched slot per peak */
+} PeakTrackerFP;
+
+PeakResultFP peak_tracker_init(PeakTrackerFP *tracker, const PeakTrackerConfigFP *config);
+
+PeakResultFP peak_tracker_update(PeakTrackerFP *tracker,
+                                 const PeakInfoFP peaks[],
+                                 int32_t num_peaks,
+                                 int32_t track_ids[]);
+
+PeakResultFP peak_tracker_tracks(const PeakTrackerFP *tracker,
+                                 PeakTrackFP tracks[],
+                                 int32_t max_tracks,
+                                 int32_t *num_tracks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PEAK_TRACKER_H */
@@ -0,0 +1,337 @@
+/*!
+ * Lock-Free SPSC Sample Ring
+ *
+ * Producer: sample_ring_push() or sample_ring_write_span() +
+ * sample_ring_commit(). Consumer: sample_ring_read_span() +
+ * sample_ring_release(), or sample_ring_stream_next() to run a
+ * PeakStreamFP over the ring in place.
+ *
+ * Ordering: the producer fills storage, then publishes head with a
+ * release store; the consumer reads head with an acquire load before
+ * touching storage. Symmetrically, the consumer publishes tail (release)
+ * only after it is done with the samples, and the producer reads tail
+ * (acquire) before overwriting them.
+ */
+
+#include <stddef.h>
+#include "sample-ring.h"
+
+/*!
+ * @brief Advance a ring index by n, wrapping at 2*capacity.
+ */
+static inline uint32_t ring_advance(const SampleRing *ring, uint32_t index, uint32_t n)
+{
+    uint32_t next = index + n;
+
+    return (next >= (2U * ring->capacity)) ? (next - (2U * ring->capacity)) : next;
+}
+
+/*!
+ * @brief Storage offset of a ring index.
+ */
+static inline uint32_t ring_offset(const SampleRing *ring, uint32_t index)
+{
+    return (index >= ring->capacity) ? (index - ring->capacity) : index;
+}
+
+/*!
+ * @brief Samples between tail and head.
+ */
+static inline uint32_t ring_used(const SampleRing *ring, uint32_t head, uint32_t tail)
+{
+    return (head >= tail) ? (head - tail) : ((2U * ring->capacity) - tail + head);
+}
+
+/*!
+ * @brief Initialise an empty ring over caller-provided storage.
+ *
+ * @param ring Ring state
+ * @param storage Sample storage of capacity samples
+ * @param capacity Ring size (1 .. 2^30); use a multiple of the detector
+ *        frame length for zero-copy streaming
+ * @return PEAK_FP_OK on success, error code otherwise
+ */
+PeakResultFP sample_ring_init(SampleRing *ring, int16_t storage[], uint32_t capacity)
+{
+    if ((ring == NULL) || (storage == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    if ((capacity == 0U) || (capacity > (1UL << 30))) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    ring->storage = storage;
+    ring->capacity = capacity;
+    ring->claimed = 0U;
+    atomic_init(&ring->head, 0U);
+    atomic_init(&ring->tail, 0U);
+
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Samples currently readable (approximate if called concurrently).
+ */
+uint32_t sample_ring_count(const SampleRing *ring)
+{
+    if (ring == NULL) {
+        return 0U;
+    }
+
+    return ring_used(ring,
+                     (uint32_t)atomic_load_explicit(&ring->head, memory_order_acquire),
+                     (uint32_t)atomic_load_explicit(&ring->tail, memory_order_acquire));
+}
+
+/*!
+ * @brief Producer: contiguous free space at head.
+ *
+ * For DMA or block producers: write up to the returned number of samples
+ * into *span, then publish them with sample_ring_commit().
+ *
+ * @param ring Ring state
+ * @param span Output: first free sample
+ * @return Contiguous free samples (0 when full)
+ */
+uint32_t sample_ring_write_span(SampleRing *ring, int16_t **span)
+{
+    uint32_t head;
+    uint32_t tail;
+    uint32_t free_total;
+    uint32_t offset;
+    uint32_t to_end;
+
+    if ((ring == NULL) || (span == NULL)) {
+        return 0U;
+    }
+
+    head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_relaxed);
+    tail = (uint32_t)atomic_load_explicit(&ring->tail, memory_order_acquire);
+    free_total = ring->capacity - ring_used(ring, head, tail);
+    offset = ring_offset(ring, head);
+    to_end = ring->capacity - offset;
+
+    *span = &ring->storage[offset];
+
+    return (free_total < to_end) ? free_total : to_end;
+}
+
+/*!
+ * @brief Producer: publish count samples written via sample_ring_write_span().
+ */
+void sample_ring_commit(SampleRing *ring, uint32_t count)
+{
+    uint32_t head;
+
+    if ((ring == NULL) || (count == 0U)) {
+        return;
+    }
+
+    head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, ring_advance(ring, head, count), memory_order_release);
+}
+
+/*!
+ * @brief Producer: copy samples into the ring (ISR-safe).
+ *
+ * @param ring Ring state
+ * @param samples Samples to append
+ * @param count Number of samples
+ * @return Samples accepted (less than count when the ring is full)
+ */
+uint32_t sample_ring_push(SampleRing *ring, const int16_t samples[], uint32_t count)
+{
+    uint32_t pushed = 0U;
+
+    if ((ring == NULL) || (samples == NULL)) {
+        return 0U;
+    }
+
+    /* At most two spans: up to the end of storage, then from the start */
+    while (pushed < count) {
+        int16_t *span;
+        uint32_t space = sample_ring_write_span(ring, &span);
+        uint32_t n = ((count - pushed) < space) ? (count - pushed) : space;
+        uint32_t i;
+
+        if (n == 0U) {
+            break;
+        }
+
+        for (i = 0U; i < n; i++) {
+            span[i] = samples[pushed + i];
+        }
+        sample_ring_commit(ring, n);
+        pushed += n;
+    }
+
+    return pushed;
+}
+
+/*!
+ * @brief Consumer: contiguous readable samples at tail.
+ *
+ * The samples stay valid until released with sample_ring_release().
+ *
+ * @param ring Ring state
+ * @param span Output: oldest unreleased sample
+ * @return Contiguous readable samples (0 when empty)
+ */
+uint32_t sample_ring_read_span(SampleRing *ring, const int16_t **span)
+{
+    uint32_t head;
+    uint32_t tail;
+    uint32_t used;
+    uint32_t offset;
+    uint32_t to_end;
+
+    if ((ring == NULL) || (span == NULL)) {
+        return 0U;
+    }
+
+    head = (uint32_t)atomic_load_explicit(&ring->head, memory_order_acquire);
+    tail = (uint32_t)atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    used = ring_used(ring, head, tail);
+    offset = ring_offset(ring, tail);
+    to_end = ring->capacity - offset;
+
+    *span = &ring->storage[offset];
+
+    return (used < to_end) ? used : to_end;
+}
+
+/*!
+ * @brief Consumer: hand count samples back to the producer.
+ */
+void sample_ring_release(SampleRing *ring, uint32_t count)
+{
+    uint32_t tail;
+
+    if ((ring == NULL) || (count == 0U)) {
+        return;
+    }
+
+    tail = (uint32_t)atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, ring_advance(ring, tail, count), memory_order_release);
+}
+
+/*!
+ * @brief Consumer: the newest count samples as at most two spans.
+ *
+ * Nothing is copied or released; pass the spans to
+ * find_prominent_peak_fp_spans() to analyse a sliding window of the ring.
+ * The samples stay valid until the consumer releases them.
+ *
+ * @param ring Ring state
+ * @param count Window length
+ * @param head Output: older span
+ * @param head_length Output: samples in head
+ * @param tail Output: newer span (after the wrap), NULL if none
+ * @param tail_length Output: samples in tail
+ * @return PEAK_FP_OK, or PEAK_FP_BUFFER_TOO_SMALL if fewer than count
+ *         samples are readable
+ */
+PeakResultFP sample_ring_peek_last(SampleRing *ring,
+                                   uint32_t count,
+                                   const int16_t **head,
+                                   int32_t *head_length,
+                                   const int16_t **tail,
+                                   int32_t *tail_length)
+{
+    uint32_t head_index;
+    uint32_t tail_index;
+    uint32_t end;
+    uint32_t start;
+
+    if ((ring == NULL) || (head == NULL) || (head_length == NULL) ||
+        (tail == NULL) || (tail_length == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    head_index = (uint32_t)atomic_load_explicit(&ring->head, memory_order_acquire);
+    tail_index = (uint32_t)atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (ring_used(ring, head_index, tail_index) < count) {
+        return PEAK_FP_BUFFER_TOO_SMALL;
+    }
+
+    /* Window [end - count, end) in storage offsets, end in (0, capacity] */
+    end = ring_offset(ring, head_index);
+    end = (end == 0U) ? ring->capacity : end;
+
+    if (count <= end) {
+        start = end - count;
+        *head = &ring->storage[start];
+        *head_length = (int32_t)count;
+        *tail = NULL;
+        *tail_length = 0;
+    } else {
+        start = ring->capacity - (count - end);
+        *head = &ring->storage[start];
+        *head_length = (int32_t)(count - end);
+        *tail = ring->storage;
+        *tail_length = (int32_t)end;
+    }
+
+    return PEAK_FP_OK;
+}
+
+/*!
+ * @brief Consumer: yield the next peak of a stream fed from the ring.
+ *
+ * Whole frames are handed to the stream straight from ring storage and
+ * scanned in place; each is released to the producer once the stream has
+ * yielded its last peak. Partial frames stay in the ring until
+ * complete, so with a capacity that is a multiple of the frame length no
+ * sample is ever copied. Otherwise a frame cut by the wrap is assembled
+ * in the stream's frame buffer.
+ *
+ * @param ring Ring state (consumer side)
+ * @param stream Stream initialised with peak_stream_init(); feed it only
+ *        through this function
+ * @param peak Output: next peak (stream-relative index)
+ * @return PEAK_FP_OK if a peak was produced, PEAK_FP_NO_PEAK_FOUND when
+ *         the ring holds no further complete frame
+ */
+PeakResultFP sample_ring_stream_next(SampleRing *ring,
+                                     PeakStreamFP *stream,
+                                     PeakInfoFP *peak)
+{
+    const int16_t *span;
+    uint32_t available;
+    uint32_t frame_length;
+    uint32_t need;
+
+    if ((ring == NULL) || (stream == NULL) || (peak == NULL)) {
+        return PEAK_FP_INVALID_INPUT;
+    }
+
+    frame_length = (uint32_t)stream->frame_length;
+
+    for (;;) {
+        if (peak_stream_next(stream, peak) == PEAK_FP_OK) {
+            return PEAK_FP_OK;
+        }
+
+        /* Stream has drained everything it was fed */
+        sample_ring_release(ring, ring->claimed);
+        ring->claimed = 0U;
+
+        available = sample_ring_read_span(ring, &span);
+        need = frame_length - (uint32_t)stream->fill;
+
+        if (available >= need) {
+            /* One frame at a time, so the producer gets space back early */
+            available = need;
+        } else if ((available == 0U) ||
+                   ((span + available) != &ring->storage[ring->capacity])) {
+            return PEAK_FP_NO_PEAK_FOUND;
+        } else {
+            /* Frame cut by the wrap: copy the head part into the frame */
+        }
+
+        (void)peak_stream_feed(stream, span, (int32_t)available);
+        ring->claimed = available;
+    }
+}
@@ -0,0 +1,79 @@
+/*!
+ * Lock-Free SPSC Sample Ring
+ *
+ * Single-producer/single-consumer ring of int16_t samples between an
+ * ADC interrupt or DMA callback (producer) and the detection task
+ * (consumer). The producer only writes head and the consumer only
+ * writes tail, so both sides are plain C11 atomic loads and stores with
+ * acquire/release ordering: no locks, no read-modify-write instructions,
+ * safe to call from an ISR.
+ *
+ * head and tail live on separate cache lines so the two sides do not
+ * bounce a line between cores on the host simulator.
+ *
+ * When the capacity is a multiple of the detector frame length and the
+ * consumer releases whole frames, no frame ever straddles the wrap, and
+ * sample_ring_stream_next() lets PeakStreamFP scan frames directly in
+ * ring storage without copying.
+ */
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "embedded-signal-peaks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Destructive-interference size (host); 32 is enough on Cortex-M7 */
+#ifndef SAMPLE_RING_CACHE_LINE
+#define SAMPLE_RING_CACHE_LINE (64)
+#endif
+
+/*!
+ * Ring state. Indices run over [0, 2*capacity) so that a full ring and
+ * an empty ring are distinguishable without a spare slot.
+ * Treat the fields as private.
+ */
+typedef struct {
+    _Alignas(SAMPLE_RING_CACHE_LINE) atomic_uint_least32_t head;  /* Producer-owned */
+    _Alignas(SAMPLE_RING_CACHE_LINE) atomic_uint_least32_t tail;  /* Consumer-owned */
+    uint32_t claimed;                  /* Samples handed to a stream, not yet released */
+    _Alignas(SAMPLE_RING_CACHE_LINE) int16_t *storage;           /* Read-only after init */
+    uint32_t capacity;
+} SampleRing;
+
+PeakResultFP sample_ring_init(SampleRing *ring, int16_t storage[], uint32_t capacity);
+
+uint32_t sample_ring_count(const SampleRing *ring);
+
+uint32_t sample_ring_push(SampleRing *ring, const int16_t samples[], uint32_t count);
+
+uint32_t sample_ring_write_span(SampleRing *ring, int16_t **span);
+
+void sample_ring_commit(SampleRing *ring, uint32_t count);
+
+uint32_t sample_ring_read_span(SampleRing *ring, const int16_t **span);
+
+void sample_ring_release(SampleRing *ring, uint32_t count);
+
+PeakResultFP sample_ring_peek_last(SampleRing *ring,
+                                   uint32_t count,
+                                   const int16_t **head,
+                                   int32_t *head_length,
+                                   const int16_t **tail,
+                                   int32_t *tail_length);
+
+PeakResultFP sample_ring_stream_next(SampleRing *ring,
+                                     PeakStreamFP *stream,
+                                     PeakInfoFP *peak);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_RING_H */
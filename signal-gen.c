@@ -0,0 +1,352 @@
+/*!
+ * Deterministic Synthetic Signal Generator
+ *
+ * Every operation is integer-only (lookup tables with linear
+ * interpolation, 64-bit intermediates), so the output does not depend on
+ * the floating-point unit or on libm.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "signal-gen.h"
+
+/* PCG32 multiplier (O'Neill, 2014) */
+#define SIGNAL_PCG_MULT (6364136223846793005ULL)
+
+/* Far-away pulse centre used before the first and after the last pulse */
+#define SIGNAL_NO_PULSE (INT64_MAX / 4)
+
+/* 10^(-1/20) and 10^(1/20) in Q16.16: one dB of amplitude */
+#define SIGNAL_DB_DOWN_Q16 (58409)
+#define SIGNAL_DB_UP_Q16 (73533)
+
+/* sin(pi/2 * i/64) in Q15, i = 0..64 */
+static const int16_t s_quarter_sine_q15[65] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512,
+    10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846,
+    17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594, 23170,
+    23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105,
+    28510, 28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113, 31356,
+    31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728,
+    32757, 32767
+};
+
+/* exp(-x^2) in Q15 for x = i/16, i = 0..64 */
+static const int16_t s_gauss_q15[65] = {
+    32767, 32639, 32259, 31635, 30782, 29718, 28468, 27059, 25519, 23879,
+    22171, 20425, 18670, 16933, 15238, 13606, 12054, 10596, 9242, 7999, 6868,
+    5852, 4947, 4150, 3454, 2852, 2337, 1900, 1533, 1227, 974, 768, 600, 466,
+    358, 274, 207, 156, 116, 86, 63, 46, 33, 24, 17, 12, 8, 6, 4, 3, 2, 1, 1,
+    1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+/*!
+ * @brief Seed a PCG32 generator.
+ *
+ * @param rng Generator state
+ * @param seed Initial state
+ * @param stream Sequence selector (independent streams for equal seeds)
+ */
+void signal_rng_seed(SignalRng *rng, uint64_t seed, uint64_t stream)
+{
+    if (rng == NULL) {
+        return;
+    }
+
+    rng->state = 0U;
+    rng->inc = (stream << 1) | 1U;
+    (void)signal_rng_next(rng);
+    rng->state += seed;
+    (void)signal_rng_next(rng);
+}
+
+/*!
+ * @brief Next 32-bit output of a PCG32 generator.
+ */
+uint32_t signal_rng_next(SignalRng *rng)
+{
+    uint64_t old = rng->state;
+    uint32_t xorshifted;
+    uint32_t rot;
+
+    rng->state = (old * SIGNAL_PCG_MULT) + rng->inc;
+    xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    rot = (uint32_t)(old >> 59);
+
+    return (xorshifted >> rot) | (xorshifted << ((32U - rot) & 31U));
+}
+
+/*!
+ * @brief Uniform integer in [0, bound) without modulo bias.
+ *
+ * @return 0 when bound is 0
+ */
+uint32_t signal_rng_below(SignalRng *rng, uint32_t bound)
+{
+    uint32_t threshold;
+    uint32_t r;
+
+    if (bound == 0U) {
+        return 0U;
+    }
+
+    threshold = (0U - bound) % bound;
+    do {
+        r = signal_rng_next(rng);
+    } while (r < threshold);
+
+    return r % bound;
+}
+
+/*!
+ * @brief Approximately standard-normal sample in Q16.16.
+ *
+ * Irwin-Hall sum of twelve 16-bit uniforms: mean 0, standard deviation
+ * exactly 1.0, tails bounded at +/-6.
+ */
+int32_t signal_rng_gauss_q16(SignalRng *rng)
+{
+    int32_t sum = 0;
+    int32_t k;
+
+    for (k = 0; k < 6; k++) {
+        uint32_t r = signal_rng_next(rng);
+        sum += (int32_t)(r & 0xFFFFU) + (int32_t)(r >> 16);
+    }
+
+    return sum - 393210;  /* 12 * 32767.5 */
+}
+
+/*!
+ * @brief sin(2*pi * phase / 2^32) in Q15.
+ */
+int32_t signal_sine_q15(uint32_t phase)
+{
+    uint32_t quadrant = phase >> 30;
+    uint32_t p = phase & 0x3FFFFFFFU;
+    uint32_t idx;
+    int32_t frac;
+    int32_t a;
+    int32_t b;
+    int32_t value;
+
+    if ((quadrant & 1U) != 0U) {
+        p = 0x40000000U - p;
+    }
+
+    idx = p >> 24;
+    frac = (int32_t)((p >> 16) & 0xFFU);
+    a = s_quarter_sine_q15[idx];
+    b = (idx < 64U) ? s_quarter_sine_q15[idx + 1U] : a;
+    value = a + (((b - a) * frac) / 256);
+
+    return (quadrant >= 2U) ? -value : value;
+}
+
+/*!
+ * @brief exp(-(offset/width)^2) in Q15 (0 beyond 4 widths).
+ */
+int32_t signal_gauss_q15(int32_t offset, int32_t width)
+{
+    int64_t x;
+    int64_t x_q8;
+    int32_t idx;
+    int32_t frac;
+    int32_t a;
+    int32_t b;
+
+    width = (width < 1) ? 1 : width;
+    x = (offset < 0) ? -(int64_t)offset : (int64_t)offset;
+
+    if (x >= (4 * (int64_t)width)) {
+        return 0;
+    }
+
+    x_q8 = (x * 16 * 256) / width;
+    idx = (int32_t)(x_q8 >> 8);
+    frac = (int32_t)(x_q8 & 0xFF);
+    a = s_gauss_q15[idx];
+    b = s_gauss_q15[idx + 1];
+
+    return a + (((b - a) * frac) / 256);
+}
+
+/*!
+ * @brief Noise RMS giving a requested SNR for a pulse amplitude.
+ *
+ * SNR is defined as 20*log10(amplitude / noise_rms) and applied in 1 dB
+ * steps of 10^(-1/20) in Q16.16.
+ *
+ * @param amplitude Pulse peak height
+ * @param snr_db Signal-to-noise ratio in dB (clamped to +/-120)
+ * @return Noise standard deviation in counts
+ */
+int32_t signal_noise_rms_for_snr(int32_t amplitude, int32_t snr_db)
+{
+    int64_t rms_q16 = (int64_t)amplitude * 65536;
+    int32_t db = (snr_db < 0) ? -snr_db : snr_db;
+    int64_t step = (snr_db < 0) ? SIGNAL_DB_UP_Q16 : SIGNAL_DB_DOWN_Q16;
+    int32_t k;
+
+    db = (db > 120) ? 120 : db;
+    for (k = 0; k < db; k++) {
+        rms_q16 = (rms_q16 * step) / 65536;
+    }
+
+    rms_q16 = (rms_q16 + 32768) / 65536;
+
+    return (rms_q16 > INT32_MAX) ? INT32_MAX : (int32_t)rms_q16;
+}
+
+/*!
+ * @brief Pulse shape at offset samples from its centre, in Q15.
+ *
+ * QRS: Q = -1/8 at -2w, R = 1 at 0, S = -1/4 at +2w (all width w), and a
+ * T wave of 1/4 at +10w with width 3w.
+ */
+static int32_t pulse_shape_q15(SignalPulseShape shape, int64_t offset, int32_t width)
+{
+    int32_t t;
+
+    if ((offset <= -(8 * (int64_t)width)) || (offset >= (24 * (int64_t)width))) {
+        return 0;
+    }
+
+    t = (int32_t)offset;
+
+    if (shape == SIGNAL_PULSE_QRS) {
+        return signal_gauss_q15(t, width) -
+               (signal_gauss_q15(t + (2 * width), width) / 8) -
+               (signal_gauss_q15(t - (2 * width), width) / 4) +
+               (signal_gauss_q15(t - (10 * width), 3 * width) / 4);
+    }
+
+    return signal_gauss_q15(t, width);
+}
+
+/*!
+ * @brief Schedule the pulse after centre_next.
+ */
+static void schedule_next_pulse(SignalGen *gen)
+{
+    const SignalGenConfig *cfg = &gen->config;
+
+    gen->centre_prev = gen->centre_next;
+    gen->amplitude_prev = gen->amplitude_next;
+
+    if (cfg->pulse_period <= 0) {
+        gen->centre_next = SIGNAL_NO_PULSE;
+        gen->amplitude_next = 0;
+    } else {
+        gen->centre_next = gen->centre_prev + cfg->pulse_period +
+                           (int64_t)signal_rng_below(&gen->rng, (uint32_t)cfg->pulse_jitter + 1U);
+        gen->amplitude_next = cfg->pulse_amplitude +
+                              (int32_t)signal_rng_below(&gen->rng,
+                                                        (uint32_t)cfg->pulse_amplitude_spread + 1U);
+    }
+}
+
+/*!
+ * @brief Initialise a generator.
+ *
+ * @param gen Generator state
+ * @param config Configuration (copied)
+ */
+void signal_gen_init(SignalGen *gen, const SignalGenConfig *config)
+{
+    if ((gen == NULL) || (config == NULL)) {
+        return;
+    }
+
+    memset(gen, 0, sizeof(*gen));
+    gen->config = *config;
+    gen->config.pulse_width = (config->pulse_width < 1) ? 1 : config->pulse_width;
+    gen->config.pulse_jitter = (config->pulse_jitter < 0) ? 0 : config->pulse_jitter;
+    gen->config.pulse_amplitude_spread = (config->pulse_amplitude_spread < 0) ?
+                                         0 : config->pulse_amplitude_spread;
+    gen->chirp_step = config->chirp_step_start;
+
+    signal_rng_seed(&gen->rng, config->seed, 0x5EEDU);
+
+    gen->centre_prev = -SIGNAL_NO_PULSE;
+    gen->amplitude_prev = 0;
+    if ((config->pulse_amplitude != 0) || (config->pulse_amplitude_spread > 0)) {
+        gen->centre_next = config->pulse_first;
+        gen->amplitude_next = config->pulse_amplitude +
+                              (int32_t)signal_rng_below(&gen->rng,
+                                                        (uint32_t)gen->config.pulse_amplitude_spread + 1U);
+    } else {
+        gen->centre_next = SIGNAL_NO_PULSE;
+        gen->amplitude_next = 0;
+    }
+}
+
+/*!
+ * @brief Generate the next count samples of the stream.
+ *
+ * Output is saturated to int16_t. The result does not depend on how the
+ * stream is split into blocks.
+ *
+ * @param gen Generator state
+ * @param out Output samples
+ * @param count Number of samples to generate
+ */
+void signal_gen_block(SignalGen *gen, int16_t out[], int32_t count)
+{
+    const SignalGenConfig *cfg;
+    int32_t i;
+
+    if ((gen == NULL) || (out == NULL)) {
+        return;
+    }
+
+    cfg = &gen->config;
+
+    for (i = 0; i < count; i++) {
+        int64_t value = cfg->baseline;
+
+        /* Drift and wander */
+        gen->drift_acc_q16 += cfg->drift_q16;
+        value += (gen->drift_acc_q16 + 32768) >> 16;
+        if (cfg->wander_amplitude != 0) {
+            value += ((int64_t)cfg->wander_amplitude * signal_sine_q15(gen->wander_phase)) /
+                     SIGNAL_Q15_ONE;
+            gen->wander_phase += cfg->wander_step;
+        }
+
+        /* Pulse train: the neighbouring pulses on either side */
+        while (gen->position >= gen->centre_next) {
+            schedule_next_pulse(gen);
+        }
+        value += ((int64_t)gen->amplitude_prev *
+                  pulse_shape_q15(cfg->pulse_shape, gen->position - gen->centre_prev,
+                                  cfg->pulse_width)) / SIGNAL_Q15_ONE;
+        value += ((int64_t)gen->amplitude_next *
+                  pulse_shape_q15(cfg->pulse_shape, gen->position - gen->centre_next,
+                                  cfg->pulse_width)) / SIGNAL_Q15_ONE;
+
+        /* Linear chirp */
+        if (cfg->chirp_amplitude != 0) {
+            value += ((int64_t)cfg->chirp_amplitude * signal_sine_q15(gen->chirp_phase)) /
+                     SIGNAL_Q15_ONE;
+            gen->chirp_phase += gen->chirp_step;
+            gen->chirp_step += (uint32_t)cfg->chirp_step_rate;
+        }
+
+        /* Gaussian noise */
+        if (cfg->noise_rms != 0) {
+            value += (((int64_t)signal_rng_gauss_q16(&gen->rng) * cfg->noise_rms) + 32768) >> 16;
+        }
+
+        if (value > INT16_MAX) {
+            value = INT16_MAX;
+        } else if (value < INT16_MIN) {
+            value = INT16_MIN;
+        } else {
+            /* In range */
+        }
+
+        out[i] = (int16_t)value;
+        gen->position++;
+    }
+}